@@ -1,8 +1,8 @@
-#include <fstream>
 #include <iostream>
-#include <sstream>
 
+#include "curves/CurveFitting.h"
 #include "curves/LinearSpline.h"
+#include "curves/StrokeFile.h"
 #include "surfaces/DynamicSurface.h"
 #include "surfaces/HermiteSurface.h"
 #include "viewer/Viewer.h"
@@ -10,50 +10,33 @@
 
 static void createSurface(DynamicSurface& surface, float t0, float t1, size_t nbStrokes, Viewer& viewer)
 {
-    float tStep = (t1 - t0) / (nbStrokes - 1);
+    StrokeSweep sweep = surface.interpolateRange(t0, t1, nbStrokes);
 
-    for (size_t i = 0; i < nbStrokes; ++i)
+    for (size_t i = 0; i < sweep.getStrokeCount(); ++i)
     {
-        float t = t0 + i * tStep;
-
-        CurvePtr curve = surface.interpolate(t);
-        if (curve)
-        {
-            GLCurvePtr glCurve = std::make_shared<GLCurve>(curve);
-            glCurve->drawControlPoints(false);
-            glCurve->tesselate();
-            viewer.addCurve(glCurve);
-        }
+        GLCurvePtr glCurve = std::make_shared<GLCurve>(sweep.createCurve(i));
+        glCurve->drawControlPoints(false);
+        glCurve->tesselate();
+        viewer.addCurve(glCurve);
     }
 }
 
-static CurvePtr loadSplineFromFile(const std::string& fileName)
+/**
+ * Loads a stroke (one "x y z" point per line). With a positive tolerance, the points are fitted
+ * by a Hermite spline with far fewer points (see fit_hermite), instead of a LinearSpline.
+ */
+static CurvePtr loadSplineFromFile(const std::string& fileName, float tolerance = 0.0f)
 {
-    std::ifstream stream(fileName);
-    if (stream.is_open())
-    {
-        std::vector<glm::vec3> samples;
-
-        std::string line;
-        while (getline(stream, line))
-        {
-            std::stringstream ss(line);
+    std::vector<glm::vec3> samples;
+    if (!StrokeFile::readText(fileName, samples))
+        return nullptr;
 
-            float x, y, z;
-            ss >> x >> y >> z;
+    if (tolerance > 0.0f)
+        return fit_hermite(samples, tolerance);
 
-            samples.push_back(glm::vec3(x, y, z));
-        }
-
-        stream.close();
-        return std::make_shared<LinearSpline>(samples);
-    }
-
-    Logger::Error("loadSplineFromFile : failed to open file " + fileName);
-    return nullptr;
+    return std::make_shared<LinearSpline>(samples);
 }
 
-
 int main()
 {
     Logger::SetMinLogLevel(LogLevel::DEBUG_LVL);
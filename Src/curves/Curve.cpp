@@ -0,0 +1,301 @@
+#include "curves/Curve.h"
+
+#include "curves/CurveBVH.h"
+#include "curves/CurveDispatch.h"
+#include "curves/SplineCore.h"
+#include "utils/ThreadPool.h"
+
+
+const size_t Curve::BATCH_SIZE;
+
+// Maximum number of subdivisions of a segment by adaptive_params
+static const int MAX_SUBDIVISION_DEPTH = 12;
+
+// Step of the finite differences used by the default derivatives
+static const float DERIVATIVE_STEP = 1e-3f;
+
+// Number of closest point queries per task of closest_points
+static const size_t CLOSEST_POINTS_GRAIN_SIZE = 64;
+
+
+static float curvature(const glm::vec3& D1, const glm::vec3& D2)
+{
+  float speed = glm::length(D1);
+  return (speed > 0.0f) ? glm::length(glm::cross(D1, D2)) / (speed * speed * speed) : 0.0f;
+}
+
+static glm::vec3 transformPoint(const glm::mat4& transform, const glm::vec3& P)
+{
+  glm::vec4 Q = transform * glm::vec4(P, 1.0f);
+  return (Q.w != 0.0f) ? glm::vec3(Q) / Q.w : glm::vec3(Q);
+}
+
+static float distanceToSegment(const glm::vec3& P, const glm::vec3& A, const glm::vec3& B)
+{
+  glm::vec3 AB = B - A;
+  float length2 = glm::dot(AB, AB);
+  float t = (length2 > 0.0f) ? glm::clamp(glm::dot(P - A, AB) / length2, 0.0f, 1.0f) : 0.0f;
+  return glm::length(P - (A + t * AB));
+}
+
+
+void Curve::set_point(size_t i, const glm::vec3& point)
+{
+  std::vector<glm::vec3> points = _points;
+  points[i] = point;
+  set_points(points);
+}
+
+void Curve::insert_point(size_t i, const glm::vec3& point)
+{
+  std::vector<glm::vec3> points = _points;
+  points.insert(points.begin() + i, point);
+  set_points(points);
+}
+
+void Curve::remove_point(size_t i)
+{
+  std::vector<glm::vec3> points = _points;
+  points.erase(points.begin() + i);
+  set_points(points);
+}
+
+size_t Curve::find_segment(float param, size_t hint) const
+{
+  return FindSegment(_params, param, hint);
+}
+
+void Curve::normalize_params()
+{
+  _length = NormalizeParams(_lengths, _params);
+
+  _bvh.reset();
+  ++_revision;
+}
+
+AABB Curve::compute_segment_bounds(size_t i) const
+{
+  AABB bounds;
+  bounds.extend(_points[i]);
+  bounds.extend(_points[i + 1]);
+  return bounds;
+}
+
+AABB Curve::get_bounds() const
+{
+  std::shared_ptr<const CurveBVH> bvh = get_bvh();
+  if (bvh->get_segment_count() > 0)
+    return bvh->get_bounds();
+
+  AABB bounds;
+  for (const glm::vec3& point : _points)
+    bounds.extend(point);
+  return bounds;
+}
+
+AABB Curve::get_segment_bounds(size_t i) const
+{
+  return get_bvh()->get_segment_bounds(i);
+}
+
+std::shared_ptr<const CurveBVH> Curve::get_bvh() const
+{
+  // Threads racing on the first query may each build a hierarchy: only one of them is kept
+  std::shared_ptr<const CurveBVH> bvh = std::atomic_load(&_bvh);
+  if (!bvh)
+  {
+    bvh = std::make_shared<CurveBVH>(*this);
+    std::atomic_store(&_bvh, bvh);
+  }
+  return bvh;
+}
+
+CurvePoint Curve::closest_point(const glm::vec3& query) const
+{
+  return get_bvh()->closest_point(*this, query);
+}
+
+void Curve::closest_points(const glm::vec3* queries, size_t count, CurvePoint* results) const
+{
+  std::shared_ptr<const CurveBVH> bvh = get_bvh();
+  ThreadPool::Get().parallelFor(count, CLOSEST_POINTS_GRAIN_SIZE, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+      results[i] = bvh->closest_point(*this, queries[i]);
+  });
+}
+
+std::vector<CurvePoint> Curve::closest_points(const std::vector<glm::vec3>& queries) const
+{
+  std::vector<CurvePoint> results(queries.size());
+  closest_points(queries.data(), queries.size(), results.data());
+  return results;
+}
+
+void Curve::locate(const float* params, size_t count, size_t* segments, float* ts, size_t& segment) const
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    float param = glm::clamp(params[i], 0.0f, 1.0f);
+
+    // Coherent params mostly stay in the segment of the previous one
+    if (param < _params[segment] || param >= _params[segment + 1])
+      segment = find_segment(param, segment);
+
+    segments[i] = segment;
+    ts[i] = SegmentParam(_params, segment, param);
+  }
+}
+
+void Curve::get_points(const float* params, size_t count, glm::vec3* points) const
+{
+  size_t segment = 0;
+  for (size_t i = 0; i < count; ++i)
+    points[i] = get_point(params[i], segment);
+}
+
+std::vector<glm::vec3> Curve::get_points(const std::vector<float>& params) const
+{
+  std::vector<glm::vec3> points(params.size());
+  get_points(params.data(), params.size(), points.data());
+  return points;
+}
+
+glm::vec3 Curve::get_derivative(float param) const
+{
+  float p0 = glm::clamp(param - DERIVATIVE_STEP, 0.0f, 1.0f);
+  float p1 = glm::clamp(param + DERIVATIVE_STEP, 0.0f, 1.0f);
+  return (get_point(p1) - get_point(p0)) / (p1 - p0);
+}
+
+glm::vec3 Curve::get_second_derivative(float param) const
+{
+  float p = glm::clamp(param, DERIVATIVE_STEP, 1.0f - DERIVATIVE_STEP);
+  return (get_point(p + DERIVATIVE_STEP) - 2.0f * get_point(p) + get_point(p - DERIVATIVE_STEP)) /
+         (DERIVATIVE_STEP * DERIVATIVE_STEP);
+}
+
+float Curve::get_curvature(float param) const
+{
+  return curvature(get_derivative(param), get_second_derivative(param));
+}
+
+void Curve::get_derivatives(const float* params, size_t count, glm::vec3* derivatives) const
+{
+  for (size_t i = 0; i < count; ++i)
+    derivatives[i] = get_derivative(params[i]);
+}
+
+void Curve::get_second_derivatives(const float* params, size_t count, glm::vec3* derivatives) const
+{
+  for (size_t i = 0; i < count; ++i)
+    derivatives[i] = get_second_derivative(params[i]);
+}
+
+void Curve::get_curvatures(const float* params, size_t count, float* curvatures) const
+{
+  glm::vec3 D1[BATCH_SIZE];
+  glm::vec3 D2[BATCH_SIZE];
+
+  for (size_t begin = 0; begin < count; begin += BATCH_SIZE)
+  {
+    size_t n = std::min(BATCH_SIZE, count - begin);
+    get_derivatives(params + begin, n, D1);
+    get_second_derivatives(params + begin, n, D2);
+
+    for (size_t i = 0; i < n; ++i)
+      curvatures[begin + i] = curvature(D1[i], D2[i]);
+  }
+}
+
+std::vector<glm::vec3> Curve::resample_uniform(size_t count) const
+{
+  std::vector<float> params(count);
+  float step = count > 1 ? 1.0f / (count - 1) : 0.0f;
+  for (size_t i = 0; i < count; ++i)
+    params[i] = i * step;
+
+  return get_points(params);
+}
+
+std::vector<glm::vec3> Curve::resample_arc_length(size_t count) const
+{
+  std::vector<float> lengths(count);
+  float step = count > 1 ? 1.0f / (count - 1) : 0.0f;
+  for (size_t i = 0; i < count; ++i)
+    lengths[i] = i * step;
+
+  std::vector<float> params(count);
+  arc_length_params(lengths.data(), count, params.data());
+
+  return get_points(params);
+}
+
+/**
+ * Appends to params the inner params of [a, b] subdividing it until the curve is flat enough
+ * (see adaptive_params). Pa and Pb are the transformed points at a and b.
+ * CurveT is the concrete type of the curve when known, so that get_point is not a virtual call.
+ */
+template<typename CurveT>
+static void subdivide(const CurveT& curve, float a, float b, const glm::vec3& Pa, const glm::vec3& Pb, float tolerance,
+                      const glm::mat4& transform, int depth, size_t& segment, std::vector<float>& params)
+{
+  if (depth == 0)
+    return;
+
+  // The chord must be close to the curve at the quarter points: the middle one alone
+  // cannot detect inflections.
+  float m = 0.5f * (a + b);
+  glm::vec3 Pm = transformPoint(transform, curve.get_point(m, segment));
+  float error = distanceToSegment(Pm, Pa, Pb);
+  if (error <= tolerance)
+  {
+    float q0 = 0.5f * (a + m);
+    float q1 = 0.5f * (m + b);
+    error = std::max(distanceToSegment(transformPoint(transform, curve.get_point(q0, segment)), Pa, Pb),
+                     distanceToSegment(transformPoint(transform, curve.get_point(q1, segment)), Pa, Pb));
+  }
+  if (error <= tolerance)
+    return;
+
+  subdivide(curve, a, m, Pa, Pm, tolerance, transform, depth - 1, segment, params);
+  params.push_back(m);
+  subdivide(curve, m, b, Pm, Pb, tolerance, transform, depth - 1, segment, params);
+}
+
+std::vector<float> Curve::adaptive_params(float tolerance, const glm::mat4& transform) const
+{
+  std::vector<float> params;
+  params.push_back(0.0f);
+
+  const std::vector<float>& knots = _params;
+  dispatch_curve(*this, [&](const auto& curve)
+  {
+    size_t segment = 0;
+    for (size_t i = 0; i + 1 < knots.size(); ++i)
+    {
+      float a = knots[i];
+      float b = knots[i + 1];
+      if (b <= a)
+        continue;
+
+      glm::vec3 Pa = transformPoint(transform, curve.get_point(a, segment));
+      glm::vec3 Pb = transformPoint(transform, curve.get_point(b, segment));
+      subdivide(curve, a, b, Pa, Pb, tolerance, transform, MAX_SUBDIVISION_DEPTH, segment, params);
+
+      params.push_back(b);
+    }
+  });
+
+  return params;
+}
+
+std::vector<glm::vec3> Curve::resample_adaptive(float tolerance, const glm::mat4& transform) const
+{
+  return get_points(adaptive_params(tolerance, transform));
+}
+
+void Curve::arc_length_params(const float* lengths, size_t count, float* params) const
+{
+  std::copy(lengths, lengths + count, params);
+}
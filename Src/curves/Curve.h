@@ -6,27 +6,233 @@
 
 #include <glm/glm.hpp>
 
+#include "utils/AABB.h"
 
+class CurveBVH;
+
+
+/**
+ * Curve types implemented by the library, see CurveDispatch.h.
+ * Other curves (deriving from Curve outside of the library) are OTHER.
+ */
+enum class CurveKind
+{
+    OTHER = 0,
+    HERMITE,
+    LINEAR
+};
+
+
+/**
+ * Result of a closest point query: param and position of the point of the curve closest to the
+ * query, and its distance to the query.
+ */
+struct CurvePoint
+{
+    float param;
+    glm::vec3 point;
+    float distance;
+};
+
+
+/**
+ * Evaluation methods (get_point, get_points, resample_* ...) are const and do not modify
+ * any internal state: several threads can evaluate the same curve concurrently, as long as
+ * no thread modifies it (set_points...) at the same time. Tests/CurveThreadStress.cpp checks
+ * this contract under ThreadSanitizer.
+ */
 class Curve
 {
 public:
-    Curve() {}
+    Curve() : _length(0.0f), _revision(0) {}
     Curve(const std::vector<glm::vec3>& controlPoints)
         : _points(controlPoints)
+        , _length(0.0f)
+        , _revision(0)
     {}
     const std::vector<glm::vec3> getControlPoints() const { return _points; }
-    virtual void set_points(const std::vector<glm::vec3>& controlPoints) { _points = controlPoints; }
 
-    virtual glm::vec3 get_point(float param) = 0;
+    /**
+     * Params of the control points: segment i spans [get_params()[i], get_params()[i + 1]]
+     */
+    const std::vector<float>& get_params() const { return _params; }
+
+    /**
+     * Length of each segment, and of the whole curve, as computed with the params
+     */
+    const std::vector<float>& get_lengths() const { return _lengths; }
+    float get_length() const { return _length; }
+
+    virtual void set_points(const std::vector<glm::vec3>& controlPoints) { _points = controlPoints; _bvh.reset(); ++_revision; }
+
+    /**
+     * Incremented each time the curve is modified: data derived from a curve (samples, profiles...)
+     * can be cached along with the revision they were computed from, and refreshed when it changes.
+     */
+    size_t get_revision() const { return _revision; }
+
+    /**
+     * Incremental editing of the control points: implementations only recompute the segments
+     * around the edited point, then renormalize the params from the cached segment lengths.
+     * The default implementations go through set_points.
+     */
+    virtual void set_point(size_t i, const glm::vec3& point);
+    virtual void insert_point(size_t i, const glm::vec3& point);
+    virtual void remove_point(size_t i);
+
+    virtual CurveKind kind() const { return CurveKind::OTHER; }
+
+    virtual glm::vec3 get_point(float param) const = 0;
+
+    /**
+     * Same as get_point(param), but the segment search starts from the given segment.
+     * On return, segment contains the segment in which param lies: passing it back for
+     * the next query makes coherent (e.g. increasing) queries O(1).
+     */
+    virtual glm::vec3 get_point(float param, size_t& segment) const = 0;
+
+    /**
+     * Evaluates the curve at count params and writes the results in points.
+     * Params outside of [0, 1] are clamped, as in get_point.
+     * Sorted params are evaluated in a single pass over the segments.
+     * The default implementation calls get_point for each param.
+     */
+    virtual void get_points(const float* params, size_t count, glm::vec3* points) const;
+    std::vector<glm::vec3> get_points(const std::vector<float>& params) const;
+
+    /**
+     * First and second derivatives with respect to the param, and curvature.
+     * Params outside of [0, 1] are clamped. At a segment boundary, the derivatives of the
+     * segment starting there are returned.
+     * The default implementations use finite differences of get_point.
+     */
+    virtual glm::vec3 get_derivative(float param) const;
+    virtual glm::vec3 get_second_derivative(float param) const;
+    float get_curvature(float param) const;
+
+    virtual void get_derivatives(const float* params, size_t count, glm::vec3* derivatives) const;
+    virtual void get_second_derivatives(const float* params, size_t count, glm::vec3* derivatives) const;
+    void get_curvatures(const float* params, size_t count, float* curvatures) const;
+
+    /**
+     * Returns count points evenly spaced in param.
+     * Implementations can override it with a faster, incremental evaluation.
+     */
+    virtual std::vector<glm::vec3> resample_uniform(size_t count) const;
+
+    /**
+     * Returns count points evenly spaced in arc length
+     */
+    std::vector<glm::vec3> resample_arc_length(size_t count) const;
+
+    /**
+     * Returns the params of a polyline approximating the curve: each segment is recursively
+     * subdivided until the distance between the curve and the polyline is below tolerance.
+     * Distances are measured after transformation by the given matrix (followed by the
+     * perspective division), e.g. a view-projection matrix to bound the error on screen.
+     */
+    std::vector<float> adaptive_params(float tolerance, const glm::mat4& transform = glm::mat4(1.0f)) const;
+    std::vector<glm::vec3> resample_adaptive(float tolerance, const glm::mat4& transform = glm::mat4(1.0f)) const;
+
+    /**
+     * Converts count normalized arc lengths (in [0, 1]) into params.
+     * Params are distributed along the curve according to the length of each segment,
+     * so the default implementation is the identity. Curves whose params are not
+     * proportional to the arc length inside a segment should override it.
+     */
+    virtual void arc_length_params(const float* lengths, size_t count, float* params) const;
+
+    /**
+     * Bounding boxes of the curve, and of its segment [_params[i], _params[i + 1]].
+     * They are cached with the segment hierarchy (see get_bvh), so they can be queried every
+     * frame, and are recomputed after the curve is modified.
+     */
+    AABB get_bounds() const;
+    AABB get_segment_bounds(size_t i) const;
+
+    /**
+     * Returns the point of the curve closest to query.
+     * The search goes through a bounding volume hierarchy of the segments (see CurveBVH), built
+     * on the first query and rebuilt after the curve is modified.
+     */
+    CurvePoint closest_point(const glm::vec3& query) const;
+
+    /**
+     * Closest points of count queries, computed in parallel (see ThreadPool)
+     */
+    void closest_points(const glm::vec3* queries, size_t count, CurvePoint* results) const;
+    std::vector<CurvePoint> closest_points(const std::vector<glm::vec3>& queries) const;
+
+    /**
+     * Returns the bounding volume hierarchy of the segments, building it if needed.
+     * Several threads can call it concurrently.
+     */
+    std::shared_ptr<const CurveBVH> get_bvh() const;
+
+    /**
+     * Returns the index i of the segment [_params[i], _params[i + 1][ containing param.
+     * Params after the hint are found with an exponential search starting at the hint, so that
+     * walking increasing params visits each segment at most once (O(segments + samples) overall).
+     * Params before the hint are found with a binary search.
+     * Tests/SegmentSearchBenchmark.cpp compares both with a linear scan of the params.
+     */
+    size_t find_segment(float param, size_t hint = 0) const;
+
+    /**
+     * Evaluates a curve at increasing params, walking its segments along the way.
+     */
+    class Cursor
+    {
+    public:
+        Cursor(const Curve& curve) : m_curve(curve), m_segment(0) {}
+
+        glm::vec3 operator()(float param) { return m_curve.get_point(param, m_segment); }
+
+        size_t segment() const { return m_segment; }
+        void reset() { m_segment = 0; }
+
+    private:
+        const Curve& m_curve;
+        size_t m_segment;
+    };
 
 protected:
+  /**
+   * Number of params evaluated at once by the batch evaluation kernels
+   */
+  static const size_t BATCH_SIZE = 64;
+
+  /**
+   * Batch segment search used by get_points implementations: for each param (clamped to [0, 1]),
+   * writes the segment it lies in and its local parameter in [0, 1] within this segment.
+   * segment is the search hint, and is updated with the segment of the last param.
+   */
+  void locate(const float* params, size_t count, size_t* segments, float* ts, size_t& segment) const;
+
+  /**
+   * Computes the bounding box of segment i, cached by get_segment_bounds.
+   * The default implementation returns the box of the control points i and i + 1, which only
+   * bounds curves staying between their control points (e.g. polylines): other curves must
+   * override it.
+   */
+  virtual AABB compute_segment_bounds(size_t i) const;
+
+  /**
+   * Computes _length and _params from the segment lengths, and increments the revision
+   */
+  void normalize_params();
+
   std::vector<glm::vec3> _points;
+  std::vector<float> _lengths; // Length of each segment
   std::vector<float> _params;
   float _length;
+  size_t _revision;
 
 private:
-  virtual glm::vec3 do_get_point(float param) const { assert(false); return glm::vec3(); }
+  friend class CurveBVH;
 
+  // Built on first use by get_bvh, and released when the params change
+  mutable std::shared_ptr<const CurveBVH> _bvh;
 };
 
 using CurvePtr = std::shared_ptr<Curve>;
@@ -0,0 +1,201 @@
+#include "curves/CurveBVH.h"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "curves/CurveDispatch.h"
+
+
+const size_t CurveBVH::LEAF_SIZE;
+
+// Samples per segment from which the Newton refinement starts (including the segment ends)
+static const int SEGMENT_SAMPLES = 5;
+
+// Newton steps of the refinement of a closest point
+static const int NEWTON_ITERATIONS = 4;
+
+// Halvings of a Newton step getting farther from the query, before giving up
+static const int MAX_STEP_HALVINGS = 4;
+
+// Maximum depth of the traversal stack: the tree is balanced, so this bounds 2^64 segments
+static const size_t MAX_DEPTH = 64;
+
+
+CurveBVH::CurveBVH(const Curve& curve)
+{
+  size_t segments = curve._params.size() > 1 ? curve._params.size() - 1 : 0;
+
+  _segment_bounds.resize(segments);
+  for (size_t i = 0; i < segments; ++i)
+    _segment_bounds[i] = curve.compute_segment_bounds(i);
+
+  // A balanced tree over n segments has less than 2 n / LEAF_SIZE nodes (at least the root)
+  _nodes.reserve(2 * segments / LEAF_SIZE + 1);
+  build(0, (uint32_t)segments);
+}
+
+uint32_t CurveBVH::build(uint32_t first, uint32_t count)
+{
+  uint32_t index = (uint32_t)_nodes.size();
+  _nodes.push_back(Node());
+
+  AABB bounds;
+  uint32_t right = 0;
+  if (count <= LEAF_SIZE)
+  {
+    for (uint32_t i = first; i < first + count; ++i)
+      bounds.extend(_segment_bounds[i]);
+  }
+  else
+  {
+    uint32_t half = count / 2;
+    build(first, half);
+    right = build(first + half, count - half);
+    bounds = _nodes[index + 1].bounds;
+    bounds.extend(_nodes[right].bounds);
+  }
+
+  // _nodes may have been reallocated by the children
+  Node& node = _nodes[index];
+  node.bounds = bounds;
+  node.first = first;
+  node.count = count;
+  node.right = right;
+  return index;
+}
+
+template<typename CurveT>
+void CurveBVH::closest_point_in_segment(const CurveT& curve, size_t i, const glm::vec3& query, CurvePoint& best) const
+{
+  float a = curve._params[i];
+  float b = curve._params[i + 1];
+  size_t segment = i;
+
+  // Nearest sample of the segment
+  CurvePoint nearest = { a, glm::vec3(0.0f), std::numeric_limits<float>::max() };
+  for (int k = 0; k < SEGMENT_SAMPLES; ++k)
+  {
+    float u = a + (b - a) * k / (SEGMENT_SAMPLES - 1);
+    glm::vec3 P = curve.get_point(u, segment);
+    float d = glm::dot(P - query, P - query);
+    if (d < nearest.distance)
+      nearest = { u, P, d };
+  }
+
+  // Newton steps on the derivative of the squared distance, (C(u) - Q) . C'(u) = 0. Steps
+  // getting farther are halved, so the result is never worse than the sample.
+  for (int k = 0; k < NEWTON_ITERATIONS; ++k)
+  {
+    glm::vec3 D1 = curve.get_derivative(nearest.param);
+    glm::vec3 D2 = curve.get_second_derivative(nearest.param);
+    float f = glm::dot(nearest.point - query, D1);
+    float df = glm::dot(D1, D1) + glm::dot(nearest.point - query, D2);
+
+    // Where the squared distance is concave, fall back to a Gauss-Newton step
+    if (df <= 0.0f)
+      df = glm::dot(D1, D1);
+    if (df <= 0.0f)
+      break;
+
+    bool closer = false;
+    float step = f / df;
+    for (int h = 0; h < MAX_STEP_HALVINGS && !closer; ++h, step *= 0.5f)
+    {
+      float u = glm::clamp(nearest.param - step, a, b);
+      glm::vec3 P = curve.get_point(u, segment);
+      float d = glm::dot(P - query, P - query);
+      if (d < nearest.distance)
+      {
+        nearest = { u, P, d };
+        closer = true;
+      }
+    }
+    if (!closer)
+      break;
+  }
+
+  if (nearest.distance < best.distance)
+    best = nearest;
+}
+
+// Segments of a polyline are projected exactly
+template<>
+void CurveBVH::closest_point_in_segment(const LinearSpline& curve, size_t i, const glm::vec3& query, CurvePoint& best) const
+{
+  const glm::vec3& A = curve._points[i];
+  const glm::vec3& B = curve._points[i + 1];
+  glm::vec3 AB = B - A;
+  float length2 = glm::dot(AB, AB);
+  float t = (length2 > 0.0f) ? glm::clamp(glm::dot(query - A, AB) / length2, 0.0f, 1.0f) : 0.0f;
+
+  glm::vec3 P = A + t * AB;
+  float d = glm::dot(P - query, P - query);
+  if (d < best.distance)
+    best = { glm::mix(curve._params[i], curve._params[i + 1], t), P, d };
+}
+
+template<typename CurveT>
+CurvePoint CurveBVH::closest_point_impl(const CurveT& curve, const glm::vec3& query) const
+{
+  const std::vector<glm::vec3>& points = curve._points;
+  if (points.empty())
+    return { 0.0f, glm::vec3(0.0f), std::numeric_limits<float>::max() };
+
+  // The nearest end point gives a first bound. Distances are squared during the search.
+  CurvePoint best = { 0.0f, points.front(), glm::dot(points.front() - query, points.front() - query) };
+  float lastDistance = glm::dot(points.back() - query, points.back() - query);
+  if (lastDistance < best.distance)
+    best = { 1.0f, points.back(), lastDistance };
+
+  if (_segment_bounds.empty())
+  {
+    best.distance = std::sqrt(best.distance);
+    return best;
+  }
+
+  uint32_t stack[MAX_DEPTH];
+  size_t size = 0;
+  stack[size++] = 0;
+
+  while (size > 0)
+  {
+    uint32_t index = stack[--size];
+    const Node& node = _nodes[index];
+    if (node.bounds.distance2(query) >= best.distance)
+      continue;
+
+    if (node.right == 0)
+    {
+      for (size_t i = node.first; i < node.first + node.count; ++i)
+      {
+        if (_segment_bounds[i].distance2(query) < best.distance)
+          closest_point_in_segment(curve, i, query, best);
+      }
+      continue;
+    }
+
+    // The nearest child is pushed last, so that it is visited first and tightens the bound
+    uint32_t nearChild = index + 1;
+    uint32_t farChild = node.right;
+    float nearDistance = _nodes[nearChild].bounds.distance2(query);
+    float farDistance = _nodes[farChild].bounds.distance2(query);
+    if (farDistance < nearDistance)
+    {
+      std::swap(nearChild, farChild);
+      std::swap(nearDistance, farDistance);
+    }
+    if (farDistance < best.distance)
+      stack[size++] = farChild;
+    if (nearDistance < best.distance)
+      stack[size++] = nearChild;
+  }
+
+  best.distance = std::sqrt(best.distance);
+  return best;
+}
+
+CurvePoint CurveBVH::closest_point(const Curve& curve, const glm::vec3& query) const
+{
+  return dispatch_curve(curve, [&](const auto& c) { return closest_point_impl(c, query); });
+}
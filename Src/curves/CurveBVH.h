@@ -0,0 +1,66 @@
+#ifndef __CURVE_BVH_H__
+#define __CURVE_BVH_H__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "curves/Curve.h"
+#include "utils/AABB.h"
+
+
+/**
+ * Bounding volume hierarchy over the segments of a curve (see Curve::get_bvh).
+ * Consecutive segments of a stroke are close to each other, so the tree is built by halving the
+ * range of segment indices: each node bounds a range of consecutive segments, and its children
+ * the two halves of this range. The build is linear in the number of segments.
+ * The hierarchy only stores boxes and indices: queries take the curve it was built from.
+ */
+class CurveBVH
+{
+public:
+    /**
+     * Segments per leaf
+     */
+    static const size_t LEAF_SIZE = 4;
+
+    struct Node
+    {
+        AABB bounds;
+        uint32_t first;   // First segment
+        uint32_t count;   // Number of segments
+        uint32_t right;   // Index of the right child (the left one follows the node), 0 for leaves
+    };
+
+    CurveBVH(const Curve& curve);
+
+    const AABB& get_bounds() const { return _nodes.front().bounds; }
+    const AABB& get_segment_bounds(size_t i) const { return _segment_bounds[i]; }
+    size_t get_segment_count() const { return _segment_bounds.size(); }
+    const std::vector<Node>& get_nodes() const { return _nodes; }
+
+    /**
+     * Branch and bound search of the point of curve closest to query: nodes are visited nearest
+     * first, and skipped when their box is farther than the best point found so far. In each
+     * remaining segment, the nearest of a few samples is refined by Newton steps.
+     */
+    CurvePoint closest_point(const Curve& curve, const glm::vec3& query) const;
+
+private:
+    uint32_t build(uint32_t first, uint32_t count);
+
+    template<typename CurveT>
+    CurvePoint closest_point_impl(const CurveT& curve, const glm::vec3& query) const;
+
+    template<typename CurveT>
+    void closest_point_in_segment(const CurveT& curve, size_t i, const glm::vec3& query, CurvePoint& best) const;
+
+    std::vector<AABB> _segment_bounds;
+    std::vector<Node> _nodes;
+};
+
+using CurveBVHPtr = std::shared_ptr<CurveBVH>;
+
+#endif // __CURVE_BVH_H__
@@ -0,0 +1,30 @@
+#ifndef __CURVE_DISPATCH_H__
+#define __CURVE_DISPATCH_H__
+
+#include "curves/Curve.h"
+#include "curves/HermiteSpline.h"
+#include "curves/LinearSpline.h"
+
+
+/**
+ * Static dispatch over the curve types of the library.
+ * Calls f with the curve downcast to its concrete type (HermiteSpline, LinearSpline), or as a
+ * Curve for other types. The concrete types are final, so the calls made by f are resolved at
+ * compile time and can be inlined: a loop over samples written in f only pays for one dispatch.
+ * f is typically a generic lambda, and must return the same type for all the curve types.
+ */
+template<typename F>
+auto dispatch_curve(const Curve& curve, F&& f) -> decltype(f(curve))
+{
+    switch (curve.kind())
+    {
+    case CurveKind::HERMITE:
+        return f(static_cast<const HermiteSpline&>(curve));
+    case CurveKind::LINEAR:
+        return f(static_cast<const LinearSpline&>(curve));
+    default:
+        return f(curve);
+    }
+}
+
+#endif // __CURVE_DISPATCH_H__
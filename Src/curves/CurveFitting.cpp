@@ -0,0 +1,368 @@
+#include "curves/CurveFitting.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "utils/ThreadPool.h"
+
+
+// Weight of the Catmull-Rom tangents in the least squares fit. It only matters for segments
+// with few points between their knots, and keeps the system well conditioned.
+static const float TANGENT_REGULARIZATION = 1e-3f;
+
+// Largest ratio between the lengths of neighbour segments (see balance_knots)
+static const float MAX_LENGTH_RATIO = 2.0f;
+
+// Number of fit / reparametrization steps for a set of knots
+static const int FIT_ITERATIONS = 3;
+
+
+static float distanceToSegment(const glm::vec3& P, const glm::vec3& A, const glm::vec3& B)
+{
+  glm::vec3 AB = B - A;
+  float length2 = glm::dot(AB, AB);
+  float t = (length2 > 0.0f) ? glm::clamp(glm::dot(P - A, AB) / length2, 0.0f, 1.0f) : 0.0f;
+  return glm::length(P - (A + t * AB));
+}
+
+std::vector<size_t> simplify_indices(const std::vector<glm::vec3>& points, float tolerance)
+{
+  std::vector<size_t> indices;
+  if (points.empty())
+    return indices;
+
+  std::vector<bool> kept(points.size(), false);
+  kept.front() = true;
+  kept.back() = true;
+
+  // Explicit stack: dense strokes would make the recursion too deep
+  std::vector<std::pair<size_t, size_t>> ranges;
+  if (points.size() > 2)
+    ranges.push_back(std::make_pair(size_t(0), points.size() - 1));
+
+  while (!ranges.empty())
+  {
+    size_t first = ranges.back().first;
+    size_t last = ranges.back().second;
+    ranges.pop_back();
+
+    float maxDistance = 0.0f;
+    size_t farthest = first;
+    for (size_t i = first + 1; i < last; ++i)
+    {
+      float distance = distanceToSegment(points[i], points[first], points[last]);
+      if (distance > maxDistance)
+      {
+        maxDistance = distance;
+        farthest = i;
+      }
+    }
+
+    if (maxDistance > tolerance)
+    {
+      kept[farthest] = true;
+      if (farthest - first > 1)
+        ranges.push_back(std::make_pair(first, farthest));
+      if (last - farthest > 1)
+        ranges.push_back(std::make_pair(farthest, last));
+    }
+  }
+
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    if (kept[i])
+      indices.push_back(i);
+  }
+
+  return indices;
+}
+
+std::vector<glm::vec3> simplify(const std::vector<glm::vec3>& points, float tolerance)
+{
+  std::vector<glm::vec3> simplified;
+  for (size_t i : simplify_indices(points, tolerance))
+    simplified.push_back(points[i]);
+
+  return simplified;
+}
+
+
+namespace
+{
+  /**
+   * Least squares fit of the tangents of a Hermite spline interpolating points[knots[k]].
+   * Each point between two knots has a local parameter ts[i] in its segment.
+   */
+  class HermiteFitter
+  {
+  public:
+    HermiteFitter(const std::vector<glm::vec3>& points);
+
+    HermiteSplinePtr fit(float tolerance);
+
+  private:
+    void balance_knots();
+    size_t middle(size_t first, size_t last) const;
+    void chord_params();
+    void solve_tangents();
+    void reparametrize();
+    float segment_error(size_t k) const;
+
+    glm::vec3 evaluate(size_t k, float t) const
+    {
+      return Hermite<glm::vec3>(_points[_knots[k]], _points[_knots[k + 1]], _tangents[k], _tangents[k + 1], t);
+    }
+
+    const std::vector<glm::vec3>& _points;
+    std::vector<size_t> _knots;
+    std::vector<glm::vec3> _tangents;
+    std::vector<float> _ts;
+    std::vector<float> _distances; // Distance along the polyline of each point
+  };
+
+  HermiteFitter::HermiteFitter(const std::vector<glm::vec3>& points)
+    : _points(points)
+    , _ts(points.size(), 0.0f)
+    , _distances(points.size(), 0.0f)
+  {
+    double distance = 0.0;
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+      distance += glm::length(points[i] - points[i - 1]);
+      _distances[i] = (float)distance;
+    }
+  }
+
+  HermiteSplinePtr HermiteFitter::fit(float tolerance)
+  {
+    // Hermite segments follow the points much further than polyline ones: starting from a single
+    // segment and splitting gives fewer knots than starting from a simplification of the points
+    _knots.push_back(0);
+    _knots.push_back(_points.size() - 1);
+
+    while (true)
+    {
+      balance_knots();
+      chord_params();
+      for (int i = 0; i < FIT_ITERATIONS; ++i)
+      {
+        solve_tangents();
+        reparametrize();
+      }
+      solve_tangents();
+
+      // Segments above tolerance are split in their middle
+      std::vector<size_t> knots;
+      for (size_t k = 0; k + 1 < _knots.size(); ++k)
+      {
+        knots.push_back(_knots[k]);
+
+        if (segment_error(k) > tolerance)
+          knots.push_back(middle(_knots[k], _knots[k + 1]));
+      }
+      knots.push_back(_knots.back());
+
+      if (knots.size() == _knots.size())
+        break;
+      _knots.swap(knots);
+    }
+
+    std::vector<glm::vec3> points(_knots.size());
+    for (size_t k = 0; k < _knots.size(); ++k)
+      points[k] = _points[_knots[k]];
+
+    return std::make_shared<HermiteSpline>(points, _tangents);
+  }
+
+  void HermiteFitter::balance_knots()
+  {
+    // A tangent is shared by the two segments around its knot, where it is scaled by the length
+    // of each one: segments much longer than their neighbours cannot be fitted together.
+    bool balanced = false;
+    while (!balanced)
+    {
+      balanced = true;
+
+      std::vector<size_t> knots;
+      for (size_t k = 0; k + 1 < _knots.size(); ++k)
+      {
+        knots.push_back(_knots[k]);
+
+        float length = _distances[_knots[k + 1]] - _distances[_knots[k]];
+        float neighbour = length;
+        if (k > 0)
+          neighbour = std::min(neighbour, _distances[_knots[k]] - _distances[_knots[k - 1]]);
+        if (k + 2 < _knots.size())
+          neighbour = std::min(neighbour, _distances[_knots[k + 2]] - _distances[_knots[k + 1]]);
+
+        size_t split = middle(_knots[k], _knots[k + 1]);
+        if (length > MAX_LENGTH_RATIO * neighbour && split != _knots[k])
+        {
+          knots.push_back(split);
+          balanced = false;
+        }
+      }
+      knots.push_back(_knots.back());
+
+      _knots.swap(knots);
+    }
+  }
+
+  size_t HermiteFitter::middle(size_t first, size_t last) const
+  {
+    // Point closest to the middle of the polyline between first and last, strictly inside
+    if (last - first < 2)
+      return first;
+
+    float distance = 0.5f * (_distances[first] + _distances[last]);
+    size_t i = std::lower_bound(_distances.begin() + first + 1, _distances.begin() + last, distance) - _distances.begin();
+    if (i > first + 1 && distance - _distances[i - 1] < _distances[i] - distance)
+      --i;
+
+    return std::min(i, last - 1);
+  }
+
+  void HermiteFitter::chord_params()
+  {
+    for (size_t k = 0; k + 1 < _knots.size(); ++k)
+    {
+      size_t first = _knots[k];
+      size_t last = _knots[k + 1];
+
+      float length = 0.0f;
+      for (size_t i = first; i < last; ++i)
+      {
+        _ts[i] = length;
+        length += glm::length(_points[i + 1] - _points[i]);
+      }
+
+      for (size_t i = first; i < last; ++i)
+        _ts[i] = (length > 0.0f) ? _ts[i] / length : (float)(i - first) / (last - first);
+    }
+  }
+
+  void HermiteFitter::solve_tangents()
+  {
+    typedef HermiteBasis<float> Basis;
+    size_t m = _knots.size();
+
+    // Catmull-Rom tangents of the knots, as computed by HermiteSpline
+    std::vector<glm::vec3> rhs(m);
+    for (size_t k = 0; k < m; ++k)
+    {
+      const glm::vec3& prev = _points[_knots[k > 0 ? k - 1 : 0]];
+      const glm::vec3& next = _points[_knots[k + 1 < m ? k + 1 : m - 1]];
+      rhs[k] = TANGENT_REGULARIZATION * 0.5f * (next - prev);
+    }
+
+    // Normal equations: a tangent only appears in the two segments around its knot,
+    // so the matrix is tridiagonal (diagonal, and upper = lower diagonal)
+    std::vector<float> diagonal(m, TANGENT_REGULARIZATION);
+    std::vector<float> upper(m, 0.0f);
+
+    for (size_t k = 0; k + 1 < m; ++k)
+    {
+      const glm::vec3& P0 = _points[_knots[k]];
+      const glm::vec3& P1 = _points[_knots[k + 1]];
+
+      for (size_t i = _knots[k] + 1; i < _knots[k + 1]; ++i)
+      {
+        float t = _ts[i];
+        float h0 = Basis::polynomial(Basis::POINT[0], t);
+        float h1 = Basis::polynomial(Basis::POINT[1], t);
+        float h2 = Basis::polynomial(Basis::POINT[2], t);
+        float h3 = Basis::polynomial(Basis::POINT[3], t);
+
+        glm::vec3 residual = _points[i] - h0 * P0 - h2 * P1;
+
+        diagonal[k] += h1 * h1;
+        diagonal[k + 1] += h3 * h3;
+        upper[k] += h1 * h3;
+        rhs[k] += h1 * residual;
+        rhs[k + 1] += h3 * residual;
+      }
+    }
+
+    // Thomas algorithm (the matrix is symmetric positive definite, no pivoting is needed)
+    for (size_t k = 1; k < m; ++k)
+    {
+      float factor = upper[k - 1] / diagonal[k - 1];
+      diagonal[k] -= factor * upper[k - 1];
+      rhs[k] -= factor * rhs[k - 1];
+    }
+
+    _tangents.resize(m);
+    _tangents[m - 1] = rhs[m - 1] / diagonal[m - 1];
+    for (size_t k = m - 1; k-- > 0;)
+      _tangents[k] = (rhs[k] - upper[k] * _tangents[k + 1]) / diagonal[k];
+  }
+
+  void HermiteFitter::reparametrize()
+  {
+    // One Newton step on the distance between each point and the curve
+    for (size_t k = 0; k + 1 < _knots.size(); ++k)
+    {
+      const glm::vec3& P0 = _points[_knots[k]];
+      const glm::vec3& P1 = _points[_knots[k + 1]];
+      const glm::vec3& T0 = _tangents[k];
+      const glm::vec3& T1 = _tangents[k + 1];
+
+      for (size_t i = _knots[k] + 1; i < _knots[k + 1]; ++i)
+      {
+        float t = _ts[i];
+        glm::vec3 D = evaluate(k, t) - _points[i];
+        glm::vec3 D1 = HermiteDerivative<glm::vec3>(P0, P1, T0, T1, t);
+        glm::vec3 D2 = HermiteSecondDerivative<glm::vec3>(P0, P1, T0, T1, t);
+
+        float denominator = glm::dot(D1, D1) + glm::dot(D, D2);
+        if (denominator > 0.0f)
+          _ts[i] = glm::clamp(t - glm::dot(D, D1) / denominator, 0.0f, 1.0f);
+      }
+    }
+  }
+
+  float HermiteFitter::segment_error(size_t k) const
+  {
+    float error = 0.0f;
+    for (size_t i = _knots[k] + 1; i < _knots[k + 1]; ++i)
+      error = std::max(error, glm::length(evaluate(k, _ts[i]) - _points[i]));
+
+    return error;
+  }
+}
+
+
+HermiteSplinePtr fit_hermite(const std::vector<glm::vec3>& points, float tolerance)
+{
+  if (points.size() < 2)
+    return nullptr;
+  if (points.size() == 2)
+    return std::make_shared<HermiteSpline>(points);
+
+  return HermiteFitter(points).fit(tolerance);
+}
+
+
+std::vector<std::vector<glm::vec3>> simplify(const std::vector<std::vector<glm::vec3>>& strokes, float tolerance)
+{
+  std::vector<std::vector<glm::vec3>> simplified(strokes.size());
+  ThreadPool::Get().parallelFor(strokes.size(), 1, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+      simplified[i] = simplify(strokes[i], tolerance);
+  });
+
+  return simplified;
+}
+
+std::vector<HermiteSplinePtr> fit_hermite(const std::vector<std::vector<glm::vec3>>& strokes, float tolerance)
+{
+  std::vector<HermiteSplinePtr> splines(strokes.size());
+  ThreadPool::Get().parallelFor(strokes.size(), 1, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+      splines[i] = fit_hermite(strokes[i], tolerance);
+  });
+
+  return splines;
+}
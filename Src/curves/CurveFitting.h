@@ -0,0 +1,36 @@
+#ifndef __CURVE_FITTING_H__
+#define __CURVE_FITTING_H__
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "curves/HermiteSpline.h"
+
+
+/**
+ * Ramer-Douglas-Peucker simplification of a polyline: returns the indices of the points kept
+ * (including the first and last ones), such that every point is within tolerance of the
+ * simplified polyline.
+ */
+std::vector<size_t> simplify_indices(const std::vector<glm::vec3>& points, float tolerance);
+std::vector<glm::vec3> simplify(const std::vector<glm::vec3>& points, float tolerance);
+
+/**
+ * Fits a Hermite spline through a subset of the points, such that the distance between each
+ * point and the spline is below tolerance.
+ * Tangents are fitted by least squares on the points between the knots (with a small
+ * regularization toward Catmull-Rom tangents), and the parameters of the points are refined by
+ * Newton steps. Starting from the end points, segments above tolerance are split in their middle
+ * until all of them are within it.
+ * Returns nullptr for less than 2 points.
+ */
+HermiteSplinePtr fit_hermite(const std::vector<glm::vec3>& points, float tolerance);
+
+/**
+ * Batch versions, processing the strokes in parallel (see ThreadPool)
+ */
+std::vector<std::vector<glm::vec3>> simplify(const std::vector<std::vector<glm::vec3>>& strokes, float tolerance);
+std::vector<HermiteSplinePtr> fit_hermite(const std::vector<std::vector<glm::vec3>>& strokes, float tolerance);
+
+#endif // __CURVE_FITTING_H__
@@ -0,0 +1,454 @@
+#include "curves/CurveIntersection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "curves/CurveBVH.h"
+#include "curves/CurveDispatch.h"
+#include "utils/ThreadPool.h"
+
+
+// Maximum subdivision depth of a pair of segments (each level splits one of the two pieces)
+static const int MAX_SUBDIVISION_DEPTH = 32;
+
+// Pieces are flat when their Bezier control points are within this fraction of the tolerance
+// from their chord
+static const float FLATNESS = 0.1f;
+
+// Gauss-Newton steps of the refinement of an intersection
+static const int REFINE_ITERATIONS = 4;
+
+// Curves and pairs of curves processed per task by the parallel intersection
+static const size_t SWEEP_GRAIN_SIZE = 256;
+static const size_t PAIRS_GRAIN_SIZE = 16;
+
+
+static bool overlaps(const AABB& a, const AABB& b, float tolerance)
+{
+  return glm::all(glm::lessThanEqual(a.min, b.max + tolerance)) &&
+         glm::all(glm::lessThanEqual(b.min, a.max + tolerance));
+}
+
+static float distanceToSegment(const glm::vec3& P, const glm::vec3& A, const glm::vec3& B)
+{
+  glm::vec3 AB = B - A;
+  float length2 = glm::dot(AB, AB);
+  float t = (length2 > 0.0f) ? glm::clamp(glm::dot(P - A, AB) / length2, 0.0f, 1.0f) : 0.0f;
+  return glm::length(P - (A + t * AB));
+}
+
+// Params s and t of the closest points of the segments [P0, P1] and [Q0, Q1]
+static void closestParams(const glm::vec3& P0, const glm::vec3& P1, const glm::vec3& Q0, const glm::vec3& Q1,
+                          float& s, float& t)
+{
+  glm::vec3 d1 = P1 - P0;
+  glm::vec3 d2 = Q1 - Q0;
+  glm::vec3 r = P0 - Q0;
+  float a = glm::dot(d1, d1);
+  float e = glm::dot(d2, d2);
+  float f = glm::dot(d2, r);
+
+  if (a <= 0.0f && e <= 0.0f)
+  {
+    s = t = 0.0f;
+    return;
+  }
+  if (a <= 0.0f)
+  {
+    s = 0.0f;
+    t = glm::clamp(f / e, 0.0f, 1.0f);
+    return;
+  }
+
+  float c = glm::dot(d1, r);
+  if (e <= 0.0f)
+  {
+    t = 0.0f;
+    s = glm::clamp(-c / a, 0.0f, 1.0f);
+    return;
+  }
+
+  // Closest points of the lines, clamped to the first segment, then to the second one
+  float b = glm::dot(d1, d2);
+  float denominator = a * e - b * b;
+  s = (denominator > 0.0f) ? glm::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+  t = (b * s + f) / e;
+  if (t < 0.0f)
+  {
+    t = 0.0f;
+    s = glm::clamp(-c / a, 0.0f, 1.0f);
+  }
+  else if (t > 1.0f)
+  {
+    t = 1.0f;
+    s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+  }
+}
+
+namespace
+{
+
+// Piece [u0, u1] of a segment, with the values and derivatives of the curve at its ends
+struct Piece
+{
+  float u0, u1;
+  glm::vec3 P0, P1;
+  glm::vec3 D0, D1;
+  size_t segment;
+
+  // Control points of the piece as a cubic Bezier curve
+  glm::vec3 B1() const { return P0 + D0 * ((u1 - u0) / 3.0f); }
+  glm::vec3 B2() const { return P1 - D1 * ((u1 - u0) / 3.0f); }
+
+  AABB bounds() const
+  {
+    AABB box;
+    box.extend(P0);
+    box.extend(B1());
+    box.extend(B2());
+    box.extend(P1);
+    return box;
+  }
+
+  bool is_flat(float flatness) const
+  {
+    return distanceToSegment(B1(), P0, P1) <= flatness && distanceToSegment(B2(), P0, P1) <= flatness;
+  }
+};
+
+template<typename CurveA, typename CurveB>
+class PairIntersector
+{
+public:
+  PairIntersector(const CurveA& a, const CurveB& b, float tolerance)
+    : _a(a)
+    , _b(b)
+    , _tolerance(tolerance)
+  {}
+
+  std::vector<CurveIntersection> run()
+  {
+    std::shared_ptr<const CurveBVH> bvhA = _a.get_bvh();
+    std::shared_ptr<const CurveBVH> bvhB = _b.get_bvh();
+    if (bvhA->get_segment_count() == 0 || bvhB->get_segment_count() == 0)
+      return _hits;
+
+    const std::vector<CurveBVH::Node>& nodesA = bvhA->get_nodes();
+    const std::vector<CurveBVH::Node>& nodesB = bvhB->get_nodes();
+
+    // Simultaneous descent of both hierarchies, down to the pairs of segments whose boxes overlap
+    std::vector<std::pair<uint32_t, uint32_t>> stack(1, std::make_pair(0u, 0u));
+    while (!stack.empty())
+    {
+      uint32_t indexA = stack.back().first;
+      uint32_t indexB = stack.back().second;
+      stack.pop_back();
+
+      const CurveBVH::Node& nodeA = nodesA[indexA];
+      const CurveBVH::Node& nodeB = nodesB[indexB];
+      if (!overlaps(nodeA.bounds, nodeB.bounds, _tolerance))
+        continue;
+
+      bool leafA = (nodeA.right == 0);
+      bool leafB = (nodeB.right == 0);
+      if (leafA && leafB)
+      {
+        for (size_t i = nodeA.first; i < nodeA.first + nodeA.count; ++i)
+        {
+          for (size_t j = nodeB.first; j < nodeB.first + nodeB.count; ++j)
+          {
+            if (overlaps(bvhA->get_segment_bounds(i), bvhB->get_segment_bounds(j), _tolerance))
+              intersect(segment_piece(_a, i), segment_piece(_b, j), 0);
+          }
+        }
+        continue;
+      }
+
+      // Descend the larger node
+      glm::vec3 sizeA = nodeA.bounds.size();
+      glm::vec3 sizeB = nodeB.bounds.size();
+      if (!leafA && (leafB || glm::dot(sizeA, sizeA) >= glm::dot(sizeB, sizeB)))
+      {
+        stack.push_back(std::make_pair(indexA + 1, indexB));
+        stack.push_back(std::make_pair(nodeA.right, indexB));
+      }
+      else
+      {
+        stack.push_back(std::make_pair(indexA, indexB + 1));
+        stack.push_back(std::make_pair(indexA, nodeB.right));
+      }
+    }
+
+    return merge_hits();
+  }
+
+private:
+  template<typename CurveT>
+  static Piece segment_piece(const CurveT& curve, size_t i)
+  {
+    const std::vector<float>& params = curve.get_params();
+
+    Piece piece;
+    piece.segment = i;
+    piece.u0 = params[i];
+    piece.u1 = params[i + 1];
+
+    size_t hint = i;
+    piece.P0 = curve.get_point(piece.u0, hint);
+    piece.P1 = curve.get_point(piece.u1, hint);
+    piece.D0 = derivative(curve, piece.u0, piece.segment);
+    piece.D1 = derivative(curve, piece.u1, piece.segment);
+    return piece;
+  }
+
+  // Derivative inside the segment: at its end, get_derivative returns that of the next segment
+  template<typename CurveT>
+  static glm::vec3 derivative(const CurveT& curve, float param, size_t segment)
+  {
+    float end = curve.get_params()[segment + 1];
+    return curve.get_derivative(param < end ? param : std::nextafter(end, 0.0f));
+  }
+
+  template<typename CurveT>
+  static void split(const CurveT& curve, const Piece& piece, Piece& first, Piece& second)
+  {
+    float middle = 0.5f * (piece.u0 + piece.u1);
+    size_t segment = piece.segment;
+    glm::vec3 P = curve.get_point(middle, segment);
+    glm::vec3 D = derivative(curve, middle, piece.segment);
+
+    first = piece;
+    first.u1 = middle;
+    first.P1 = P;
+    first.D1 = D;
+
+    second = piece;
+    second.u0 = middle;
+    second.P0 = P;
+    second.D0 = D;
+  }
+
+  void intersect(const Piece& pieceA, const Piece& pieceB, int depth)
+  {
+    AABB boundsA = pieceA.bounds();
+    AABB boundsB = pieceB.bounds();
+    if (!overlaps(boundsA, boundsB, _tolerance))
+      return;
+
+    float flatness = FLATNESS * _tolerance;
+    bool flatA = pieceA.is_flat(flatness);
+    bool flatB = pieceB.is_flat(flatness);
+    if ((flatA && flatB) || depth >= MAX_SUBDIVISION_DEPTH)
+    {
+      solve(pieceA, pieceB);
+      return;
+    }
+
+    // Split the larger piece which is not flat
+    glm::vec3 sizeA = boundsA.size();
+    glm::vec3 sizeB = boundsB.size();
+    Piece first, second;
+    if (!flatA && (flatB || glm::dot(sizeA, sizeA) >= glm::dot(sizeB, sizeB)))
+    {
+      split(_a, pieceA, first, second);
+      intersect(first, pieceB, depth + 1);
+      intersect(second, pieceB, depth + 1);
+    }
+    else
+    {
+      split(_b, pieceB, first, second);
+      intersect(pieceA, first, depth + 1);
+      intersect(pieceA, second, depth + 1);
+    }
+  }
+
+  // Starts from the closest points of the chords, and minimizes |A(u) - B(v)|^2 in the segments
+  // of the pieces: an intersection close to the boundary of a piece is found from both sides.
+  void solve(const Piece& pieceA, const Piece& pieceB)
+  {
+    float minU = _a.get_params()[pieceA.segment];
+    float maxU = _a.get_params()[pieceA.segment + 1];
+    float minV = _b.get_params()[pieceB.segment];
+    float maxV = _b.get_params()[pieceB.segment + 1];
+
+    float s, t;
+    closestParams(pieceA.P0, pieceA.P1, pieceB.P0, pieceB.P1, s, t);
+
+    size_t segmentA = pieceA.segment;
+    size_t segmentB = pieceB.segment;
+    float u = glm::mix(pieceA.u0, pieceA.u1, s);
+    float v = glm::mix(pieceB.u0, pieceB.u1, t);
+    glm::vec3 A = _a.get_point(u, segmentA);
+    glm::vec3 B = _b.get_point(v, segmentB);
+    float distance2 = glm::dot(A - B, A - B);
+
+    for (int k = 0; k < REFINE_ITERATIONS && distance2 > 0.0f; ++k)
+    {
+      glm::vec3 Du = derivative(_a, u, pieceA.segment);
+      glm::vec3 Dv = derivative(_b, v, pieceB.segment);
+      glm::vec3 F = A - B;
+
+      // Normal equations of the linearization F + Du du - Dv dv = 0
+      float a = glm::dot(Du, Du);
+      float b = -glm::dot(Du, Dv);
+      float c = glm::dot(Dv, Dv);
+      float ga = glm::dot(Du, F);
+      float gb = -glm::dot(Dv, F);
+      float determinant = a * c - b * b;
+      if (determinant <= 1e-12f * a * c)
+        break;
+
+      float nextU = glm::clamp(u - (c * ga - b * gb) / determinant, minU, maxU);
+      float nextV = glm::clamp(v - (a * gb - b * ga) / determinant, minV, maxV);
+      glm::vec3 nextA = _a.get_point(nextU, segmentA);
+      glm::vec3 nextB = _b.get_point(nextV, segmentB);
+      float nextDistance2 = glm::dot(nextA - nextB, nextA - nextB);
+      if (nextDistance2 >= distance2)
+        break;
+
+      u = nextU;
+      v = nextV;
+      A = nextA;
+      B = nextB;
+      distance2 = nextDistance2;
+    }
+
+    if (distance2 <= _tolerance * _tolerance)
+      _hits.push_back({ 0, 1, u, v, 0.5f * (A + B), std::sqrt(distance2) });
+  }
+
+  // Pieces sharing an intersection (e.g. at a segment boundary) report it several times, and
+  // curves crossing at a small angle stay within tolerance along a stretch of both of them.
+  // Consecutive hits are merged, keeping the closest one, when the curves are within tolerance
+  // between them.
+  std::vector<CurveIntersection> merge_hits() const
+  {
+    std::vector<CurveIntersection> hits = _hits;
+    std::sort(hits.begin(), hits.end(), [](const CurveIntersection& x, const CurveIntersection& y)
+    {
+      return x.firstParam < y.firstParam;
+    });
+
+    std::vector<CurveIntersection> merged;
+    for (const CurveIntersection& hit : hits)
+    {
+      if (!merged.empty() && same_crossing(merged.back(), hit))
+      {
+        if (hit.distance < merged.back().distance)
+          merged.back() = hit;
+      }
+      else
+        merged.push_back(hit);
+    }
+    return merged;
+  }
+
+  bool same_crossing(const CurveIntersection& x, const CurveIntersection& y) const
+  {
+    if (glm::length(x.point - y.point) <= _tolerance)
+      return true;
+
+    glm::vec3 A = _a.get_point(0.5f * (x.firstParam + y.firstParam));
+    glm::vec3 B = _b.get_point(0.5f * (x.secondParam + y.secondParam));
+    return glm::length(A - B) <= _tolerance;
+  }
+
+  const CurveA& _a;
+  const CurveB& _b;
+  float _tolerance;
+  std::vector<CurveIntersection> _hits;
+};
+
+} // namespace
+
+
+std::vector<CurveIntersection> intersect_curves(const Curve& first, const Curve& second, float tolerance)
+{
+  return dispatch_curve(first, [&](const auto& a)
+  {
+    return dispatch_curve(second, [&](const auto& b)
+    {
+      return PairIntersector<std::decay_t<decltype(a)>, std::decay_t<decltype(b)>>(a, b, tolerance).run();
+    });
+  });
+}
+
+std::vector<CurveIntersection> intersect_curves(const std::vector<CurvePtr>& curves, float tolerance)
+{
+  ThreadPool& pool = ThreadPool::Get();
+
+  // Curve bounds, building the hierarchies in parallel on the way
+  std::vector<AABB> bounds(curves.size());
+  pool.parallelFor(curves.size(), SWEEP_GRAIN_SIZE, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+    {
+      if (curves[i] && curves[i]->get_bvh()->get_segment_count() > 0)
+        bounds[i] = curves[i]->get_bvh()->get_bounds();
+    }
+  });
+
+  std::vector<size_t> order;
+  order.reserve(curves.size());
+  glm::vec3 mean(0.0f);
+  for (size_t i = 0; i < curves.size(); ++i)
+  {
+    if (!bounds[i].isEmpty())
+    {
+      order.push_back(i);
+      mean += bounds[i].center();
+    }
+  }
+  if (order.size() < 2)
+    return std::vector<CurveIntersection>();
+
+  // Sweep along the axis on which the curves are the most spread out
+  mean /= (float)order.size();
+  glm::vec3 variance(0.0f);
+  for (size_t i : order)
+    variance += (bounds[i].center() - mean) * (bounds[i].center() - mean);
+  int axis = (variance.x >= variance.y && variance.x >= variance.z) ? 0 : (variance.y >= variance.z ? 1 : 2);
+
+  std::sort(order.begin(), order.end(), [&](size_t i, size_t j) { return bounds[i].min[axis] < bounds[j].min[axis]; });
+
+  // Each curve is paired with the following ones starting before its end on the axis
+  std::vector<std::vector<std::pair<size_t, size_t>>> sweptPairs(order.size());
+  pool.parallelFor(order.size(), SWEEP_GRAIN_SIZE, [&](size_t begin, size_t end)
+  {
+    for (size_t k = begin; k < end; ++k)
+    {
+      const AABB& box = bounds[order[k]];
+      for (size_t l = k + 1; l < order.size() && bounds[order[l]].min[axis] <= box.max[axis] + tolerance; ++l)
+      {
+        if (overlaps(box, bounds[order[l]], tolerance))
+          sweptPairs[k].push_back(std::make_pair(std::min(order[k], order[l]), std::max(order[k], order[l])));
+      }
+    }
+  });
+
+  std::vector<std::pair<size_t, size_t>> pairs;
+  for (const auto& curvePairs : sweptPairs)
+    pairs.insert(pairs.end(), curvePairs.begin(), curvePairs.end());
+  std::sort(pairs.begin(), pairs.end());
+
+  std::vector<std::vector<CurveIntersection>> pairHits(pairs.size());
+  pool.parallelFor(pairs.size(), PAIRS_GRAIN_SIZE, [&](size_t begin, size_t end)
+  {
+    for (size_t k = begin; k < end; ++k)
+    {
+      pairHits[k] = intersect_curves(*curves[pairs[k].first], *curves[pairs[k].second], tolerance);
+      for (CurveIntersection& hit : pairHits[k])
+      {
+        hit.first = pairs[k].first;
+        hit.second = pairs[k].second;
+      }
+    }
+  });
+
+  std::vector<CurveIntersection> intersections;
+  for (const auto& hits : pairHits)
+    intersections.insert(intersections.end(), hits.begin(), hits.end());
+  return intersections;
+}
@@ -0,0 +1,43 @@
+#ifndef __CURVE_INTERSECTION_H__
+#define __CURVE_INTERSECTION_H__
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "curves/Curve.h"
+
+
+/**
+ * Crossing of two curves: points of the curves closer than the tolerance of the query.
+ * Sketched strokes seldom cross exactly in 3D, so the tolerance is what makes them meet.
+ */
+struct CurveIntersection
+{
+    size_t first;       // Index of the first curve
+    size_t second;      // Index of the second curve (greater than first)
+    float firstParam;
+    float secondParam;
+    glm::vec3 point;    // Midpoint of the two curve points
+    float distance;     // Distance between the two curve points
+};
+
+
+/**
+ * Intersections of two curves, sorted by param on the first curve. first and second are 0 and 1.
+ * Segment pairs are culled with the hierarchies of both curves (see CurveBVH). Each remaining
+ * pair is subdivided while the Bezier hulls of its pieces overlap, until the pieces are flat;
+ * the closest points of their chords are then refined on the curves by Gauss-Newton steps.
+ * Crossings closer than tolerance along a curve are reported once.
+ */
+std::vector<CurveIntersection> intersect_curves(const Curve& first, const Curve& second, float tolerance);
+
+/**
+ * Intersections between all the pairs of curves, sorted by curve indices then param on the
+ * first curve. Null curves are skipped, and curves are not intersected with themselves.
+ * Pairs of curves are found by sweep and prune on the curve bounds, along their axis of largest
+ * spread, then intersected in parallel (see ThreadPool).
+ */
+std::vector<CurveIntersection> intersect_curves(const std::vector<CurvePtr>& curves, float tolerance);
+
+#endif // __CURVE_INTERSECTION_H__
@@ -58,31 +58,22 @@ void GLCurve::tesselate(size_t nbSamples)
 {   
     m_controlPoints = m_curve->getControlPoints();
     
-    m_curvePoints.clear();
-    float step = 1.0f / (nbSamples - 1);
-    for (size_t u = 0; u < nbSamples; ++u)
-        m_curvePoints.push_back(m_curve->get_point(u * step));
+    m_curvePoints = m_curve->resample_uniform(nbSamples);
 
-    // Send data
-    GLCHECK(glBindVertexArray(m_vao));
+    upload();
+}
 
-    GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, m_pvbo));
-    GLCHECK(glBufferData(
-        GL_ARRAY_BUFFER,
-        m_controlPoints.size() * sizeof(glm::vec3),
-        m_controlPoints.data(),
-        GL_STATIC_DRAW
-    ));
+void GLCurve::tesselateAdaptive(float tolerance, const Camera* camera)
+{
+    m_controlPoints = m_curve->getControlPoints();
 
-    GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, m_cvbo));
-    GLCHECK(glBufferData(
-        GL_ARRAY_BUFFER,
-        m_curvePoints.size() * sizeof(glm::vec3),
-        m_curvePoints.data(),
-        GL_STATIC_DRAW
-    ));
+    glm::mat4 transform(1.0f);
+    if (camera)
+        transform = camera->getProjectionMatrix() * camera->getViewMatrix();
 
-    GLCHECK(glBindVertexArray(0));
+    m_curvePoints = m_curve->resample_adaptive(tolerance, transform);
+
+    upload();
 }
 
 void GLCurve::draw(ShaderProgram& pointProgram, ShaderProgram& curveProgram)
@@ -109,4 +100,28 @@ void GLCurve::draw(ShaderProgram& pointProgram, ShaderProgram& curveProgram)
 
     ShaderProgram::Stop();
     GLCHECK(glBindVertexArray(0));
-}
\ No newline at end of file
+}
+
+
+void GLCurve::upload()
+{
+    GLCHECK(glBindVertexArray(m_vao));
+
+    GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, m_pvbo));
+    GLCHECK(glBufferData(
+        GL_ARRAY_BUFFER,
+        m_controlPoints.size() * sizeof(glm::vec3),
+        m_controlPoints.data(),
+        GL_STATIC_DRAW
+    ));
+
+    GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, m_cvbo));
+    GLCHECK(glBufferData(
+        GL_ARRAY_BUFFER,
+        m_curvePoints.size() * sizeof(glm::vec3),
+        m_curvePoints.data(),
+        GL_STATIC_DRAW
+    ));
+
+    GLCHECK(glBindVertexArray(0));
+}
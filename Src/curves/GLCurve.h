@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 
 #include "curves/Curve.h"
+#include "viewer/Camera.h"
 #include "viewer/ShaderProgram.h"
 
 
@@ -32,6 +33,15 @@ public:
 
     void tesselate(size_t nbSamples = 50);
 
+    /**
+     * Tesselates the curve with as few points as possible, keeping the distance between the curve
+     * and the drawn polyline below tolerance.
+     * Without camera, the tolerance is in world units. With a camera, it is in normalized device
+     * coordinates (2 / viewport height is about one pixel), so the tesselation must be updated
+     * when the camera changes.
+     */
+    void tesselateAdaptive(float tolerance, const Camera* camera = nullptr);
+
     void draw(ShaderProgram& pointProgram, ShaderProgram& curveProgram);
 
 private:
@@ -50,6 +60,8 @@ private:
 
     glm::vec4 m_pointColor;
     glm::vec4 m_curveColor;
+
+    void upload();
 };
 
 using GLCurvePtr = std::shared_ptr<GLCurve>;
@@ -0,0 +1,152 @@
+#ifndef __HERMITE_BASIS_H__
+#define __HERMITE_BASIS_H__
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+
+/**
+ * Cubic Hermite basis on [0, 1], for the scalar type S.
+ * Each row gives the coefficients of the basis function of P0, T0, P1 and T1 in increasing
+ * powers of t, for the curve and for its first and second derivatives. The matrices are constexpr,
+ * and polynomial evaluates a row with Horner's scheme: once inlined, the kernels below are plain
+ * multiply-adds with immediate coefficients, without any branch or null term.
+ */
+template<typename S>
+struct HermiteBasis
+{
+    static constexpr S POINT[4][4] = {
+        { 1, 0, -3,  2 },   // h0 = 2 t^3 - 3 t^2 + 1
+        { 0, 1, -2,  1 },   // h1 = t^3 - 2 t^2 + t
+        { 0, 0,  3, -2 },   // h2 = -2 t^3 + 3 t^2
+        { 0, 0, -1,  1 }    // h3 = t^3 - t^2
+    };
+
+    static constexpr S DERIVATIVE[4][3] = {
+        { 0, -6,  6 },
+        { 1, -4,  3 },
+        { 0,  6, -6 },
+        { 0, -2,  3 }
+    };
+
+    static constexpr S SECOND_DERIVATIVE[4][2] = {
+        { -6,  12 },
+        { -4,   6 },
+        {  6, -12 },
+        { -2,   6 }
+    };
+
+    static constexpr S polynomial(const S (&c)[4], S t) { return add(c[0], t * add(c[1], t * add(c[2], t * c[3]))); }
+    static constexpr S polynomial(const S (&c)[3], S t) { return add(c[0], t * add(c[1], t * c[2])); }
+    static constexpr S polynomial(const S (&c)[2], S t) { return add(c[0], t * c[1]); }
+
+private:
+    // The coefficients are known once inlined, so the test is resolved at compile time: adding a null
+    // coefficient cannot be optimized out otherwise (x + 0 is not x for x = -0)
+    static constexpr S add(S c, S x) { return (c != S(0)) ? c + x : x; }
+};
+
+template<typename S> constexpr S HermiteBasis<S>::POINT[4][4];
+template<typename S> constexpr S HermiteBasis<S>::DERIVATIVE[4][3];
+template<typename S> constexpr S HermiteBasis<S>::SECOND_DERIVATIVE[4][2];
+
+
+/**
+ * Hermite curve at t, clamped to [0, 1]. The basis is exactly (1, 0, 0, 0) at t = 0 and
+ * (0, 0, 1, 0) at t = 1, so the end points are returned exactly without branching.
+ * T is the type of the points (a scalar or a glm vector of S).
+ */
+template<typename T, typename S = float>
+T Hermite(const T& P0, const T& P1, const T& T0, const T& T1, S t)
+{
+    using Basis = HermiteBasis<S>;
+    t = glm::clamp(t, S(0), S(1));
+
+    return Basis::polynomial(Basis::POINT[0], t) * P0 + Basis::polynomial(Basis::POINT[1], t) * T0 +
+           Basis::polynomial(Basis::POINT[2], t) * P1 + Basis::polynomial(Basis::POINT[3], t) * T1;
+}
+
+template<typename T, typename S = float>
+T HermiteDerivative(const T& P0, const T& P1, const T& T0, const T& T1, S t)
+{
+    // The basis functions derivatives of P0 and P1 are opposite: factoring them avoids a
+    // cancellation between large coordinates
+    using Basis = HermiteBasis<S>;
+    return Basis::polynomial(Basis::DERIVATIVE[2], t) * (P1 - P0) +
+           Basis::polynomial(Basis::DERIVATIVE[1], t) * T0 + Basis::polynomial(Basis::DERIVATIVE[3], t) * T1;
+}
+
+template<typename T, typename S = float>
+T HermiteSecondDerivative(const T& P0, const T& P1, const T& T0, const T& T1, S t)
+{
+    using Basis = HermiteBasis<S>;
+    return Basis::polynomial(Basis::SECOND_DERIVATIVE[2], t) * (P1 - P0) +
+           Basis::polynomial(Basis::SECOND_DERIVATIVE[1], t) * T0 +
+           Basis::polynomial(Basis::SECOND_DERIVATIVE[3], t) * T1;
+}
+
+
+/**
+ * Length of a Hermite curve between t0 and t1, by 5-point Gauss-Legendre quadrature
+ */
+template<typename T, typename S>
+S HermiteLength(const T& P0, const T& P1, const T& T0, const T& T1, S t0, S t1)
+{
+    static constexpr S NODES[5] = { S(0), S(-0.538469310105683), S(0.538469310105683),
+                                    S(-0.906179845938664), S(0.906179845938664) };
+    static constexpr S WEIGHTS[5] = { S(0.568888888888889), S(0.478628670499366), S(0.478628670499366),
+                                      S(0.236926885056189), S(0.236926885056189) };
+
+    S half = S(0.5) * (t1 - t0);
+    S center = S(0.5) * (t1 + t0);
+
+    S length = S(0);
+    for (int i = 0; i < 5; ++i)
+        length += WEIGHTS[i] * glm::length(HermiteDerivative<T, S>(P0, P1, T0, T1, center + half * NODES[i]));
+
+    return half * length;
+}
+
+/**
+ * Length of a Hermite curve on [0, 1] by adaptive quadrature: intervals are split until both
+ * halves agree with the whole interval within the relative tolerance, or after maxDepth splits.
+ * The quadrature starts from quarters of [0, 1]: on looping segments, the estimates of the whole
+ * segment and of its halves can agree by chance while both are off by much more than the
+ * tolerance (see Tests/HermiteLengthAccuracy.cpp).
+ */
+template<typename T, typename S>
+S HermiteAdaptiveLength(const T& P0, const T& P1, const T& T0, const T& T1, S tolerance, int maxDepth)
+{
+    struct Adaptive
+    {
+        static S length(const T& P0, const T& P1, const T& T0, const T& T1, S t0, S t1, S estimate,
+                        S tolerance, int depth)
+        {
+            S tm = S(0.5) * (t0 + t1);
+            S left = HermiteLength<T, S>(P0, P1, T0, T1, t0, tm);
+            S right = HermiteLength<T, S>(P0, P1, T0, T1, tm, t1);
+
+            S sum = left + right;
+            if (depth == 0 || std::abs(sum - estimate) <= tolerance * sum)
+                return sum;
+
+            return length(P0, P1, T0, T1, t0, tm, left, tolerance, depth - 1) +
+                   length(P0, P1, T0, T1, tm, t1, right, tolerance, depth - 1);
+        }
+    };
+
+    const int INITIAL_INTERVALS = 4;
+
+    S length = S(0);
+    for (int i = 0; i < INITIAL_INTERVALS; ++i)
+    {
+        S t0 = S(i) / INITIAL_INTERVALS;
+        S t1 = S(i + 1) / INITIAL_INTERVALS;
+        S estimate = HermiteLength<T, S>(P0, P1, T0, T1, t0, t1);
+        length += Adaptive::length(P0, P1, T0, T1, t0, t1, estimate, tolerance, maxDepth);
+    }
+    return length;
+}
+
+#endif // __HERMITE_BASIS_H__
@@ -1,19 +1,133 @@
 #include "HermiteSpline.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+// Number of Newton iterations refining the arc length table lookups
+static const int NEWTON_ITERATIONS = 2;
+
+// Maximum number of forward differencing steps before the differences are recomputed,
+// which bounds the accumulation of rounding errors
+static const size_t FORWARD_DIFFERENCES_STEPS = 32;
+
+// Real roots of a t^2 + b t + c, returns their number
+static int quadratic_roots(float a, float b, float c, float* roots)
+{
+  if (a == 0.0f)
+  {
+    if (b == 0.0f)
+      return 0;
+    roots[0] = -c / b;
+    return 1;
+  }
+
+  float discriminant = b * b - 4.0f * a * c;
+  if (discriminant < 0.0f)
+    return 0;
+
+  // Avoids the cancellation of the textbook formula
+  float q = -0.5f * (b + std::copysign(std::sqrt(discriminant), b));
+  roots[0] = q / a;
+  if (q == 0.0f)
+    return 1;
+  roots[1] = c / q;
+  return 2;
+}
+
+// Hermite basis functions at n local params: no branch, so that the compiler can vectorize the loop
+static void hermite_basis(const float* ts, size_t n, float* h0, float* h1, float* h2, float* h3)
+{
+  using Basis = HermiteBasis<float>;
+  for (size_t i = 0; i < n; ++i)
+  {
+    float t = ts[i];
+    h0[i] = Basis::polynomial(Basis::POINT[0], t);
+    h1[i] = Basis::polynomial(Basis::POINT[1], t);
+    h2[i] = Basis::polynomial(Basis::POINT[2], t);
+    h3[i] = Basis::polynomial(Basis::POINT[3], t);
+  }
+}
+
+// Hermite curve at n params, from the structure of arrays storage. Params are processed by runs
+// lying in the same segment: the control values are then constant, and the inner loops stream
+// the basis functions into each coordinate. Batches spanning many segments (e.g. one param per
+// segment) would make runs too short: their control values are gathered for each param instead.
+static void hermite_soa(const SoAPoints& P, const SoAPoints& T, const size_t* segments,
+                        const float* h0, const float* h1, const float* h2, const float* h3,
+                        size_t n, float* xs, float* ys, float* zs)
+{
+  const float* coordinates[3][2] = { { P.x(), T.x() }, { P.y(), T.y() }, { P.z(), T.z() } };
+  float* outs[3] = { xs, ys, zs };
+
+  size_t runs = 1;
+  for (size_t i = 1; i < n; ++i)
+    runs += (segments[i] != segments[i - 1]);
+
+  if (runs > n / 4)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      const float* Pc = coordinates[c][0];
+      const float* Tc = coordinates[c][1];
+      float* out = outs[c];
+      for (size_t i = 0; i < n; ++i)
+      {
+        size_t k = segments[i];
+        out[i] = h0[i] * Pc[k] + h1[i] * Tc[k] + h2[i] * Pc[k + 1] + h3[i] * Tc[k + 1];
+      }
+    }
+    return;
+  }
+
+  size_t begin = 0;
+  while (begin < n)
+  {
+    size_t k = segments[begin];
+    size_t end = begin + 1;
+    while (end < n && segments[end] == k)
+      ++end;
+
+    for (int c = 0; c < 3; ++c)
+    {
+      float P0 = coordinates[c][0][k], P1 = coordinates[c][0][k + 1];
+      float T0 = coordinates[c][1][k], T1 = coordinates[c][1][k + 1];
+
+      float* out = outs[c];
+      for (size_t i = begin; i < end; ++i)
+        out[i] = h0[i] * P0 + h1[i] * T0 + h2[i] * P1 + h3[i] * T1;
+    }
+
+    begin = end;
+  }
+}
 
 
 HermiteSpline::HermiteSpline()
   : Curve()
+  , _length_tolerance(1e-4f)
+  , _arc_resolution(0)
+  , _auto_tangents(true)
+  , _soa_storage(false)
 {}
 
 HermiteSpline::HermiteSpline(const std::vector<glm::vec3>& points)
   : Curve()
+  , _length_tolerance(1e-4f)
+  , _arc_resolution(0)
+  , _auto_tangents(true)
+  , _soa_storage(false)
 {
   set_points(points);
 }
 
 HermiteSpline::HermiteSpline(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& tangents)
   : Curve()
+  , _length_tolerance(1e-4f)
+  , _arc_resolution(0)
+  , _auto_tangents(true)
+  , _soa_storage(false)
 {
   set_points_tangents(points, tangents);
 }
@@ -22,6 +136,7 @@ HermiteSpline::HermiteSpline(const std::vector<glm::vec3>& points, const std::ve
 void HermiteSpline::set_points(const std::vector<glm::vec3>& points)
 {
   _points = points;
+  _auto_tangents = true;
 
   catmull_rom_tangents();
   update_params();
@@ -34,95 +149,396 @@ void HermiteSpline::set_points_tangents(const std::vector<glm::vec3>& points,
   assert(points.size() == tangents.size());
   _points = points;
   _tangents = tangents;
+  _auto_tangents = false;
+
+  update_params();
+}
+
+
+void HermiteSpline::set_point(size_t i, const glm::vec3& point)
+{
+  _points[i] = point;
+  update_around(i);
+}
+
+void HermiteSpline::insert_point(size_t i, const glm::vec3& point)
+{
+  size_t segment = std::min(i, _lengths.size());
+  size_t row = _arc_resolution > 0 ? _arc_resolution + 1 : 0;
+
+  _points.insert(_points.begin() + i, point);
+  _tangents.insert(_tangents.begin() + i, glm::vec3(0.0f));
+  _lengths.insert(_lengths.begin() + segment, 0.0f);
+  _arc_table.insert(_arc_table.begin() + segment * row, row, 0.0f);
+
+  // Explicit tangents are kept: the new point gets a Catmull-Rom tangent
+  if (!_auto_tangents)
+    _tangents[i] = catmull_rom_tangent(i);
+
+  update_around(i);
+}
+
+void HermiteSpline::remove_point(size_t i)
+{
+  assert(_points.size() > 2);
+
+  size_t segment = std::min(i, _lengths.size() - 1);
+  size_t row = _arc_resolution > 0 ? _arc_resolution + 1 : 0;
+
+  _points.erase(_points.begin() + i);
+  _tangents.erase(_tangents.begin() + i);
+  _lengths.erase(_lengths.begin() + segment);
+  _arc_table.erase(_arc_table.begin() + segment * row, _arc_table.begin() + (segment + 1) * row);
+
+  update_around(std::min(i, _points.size() - 1));
+}
+
 
+void HermiteSpline::set_length_tolerance(float tolerance)
+{
+  _length_tolerance = tolerance;
   update_params();
 }
 
+void HermiteSpline::set_soa_storage(bool enabled)
+{
+  _soa_storage = enabled;
+  update_soa();
+}
+
+void HermiteSpline::set_arc_length_resolution(size_t resolution)
+{
+  _arc_resolution = resolution;
+  _arc_table.resize(_lengths.size() * (_arc_resolution > 0 ? _arc_resolution + 1 : 0));
+
+  for (size_t i = 0; _arc_resolution > 0 && i < _lengths.size(); ++i)
+    update_arc_table(i);
+}
+
 
-float HermiteSpline::compute_length(const glm::vec3& P0, const glm::vec3& P1,
-                                    const glm::vec3& T0, const glm::vec3& T1) const
+void HermiteSpline::update_params()
+{
+  _lengths.resize(_points.size() > 0 ? _points.size() - 1 : 0);
+  _arc_table.resize(_lengths.size() * (_arc_resolution > 0 ? _arc_resolution + 1 : 0));
+
+  update_segments(0, _lengths.size());
+  normalize_params();
+  update_soa();
+}
+
+void HermiteSpline::update_segments(size_t first, size_t last)
 {
-  const unsigned int nb_samples = 20;
-  float step = 1.0f / nb_samples;
-  float length = 0.0f;
+  last = std::min(last, _lengths.size());
+  for (size_t i = first; i < last; ++i)
+  {
+    _lengths[i] = HermiteSegmentLength(_points, _tangents, i, _length_tolerance);
 
-  glm::vec3 lastPt = P0;
-  for (unsigned int i = 1; i <= nb_samples; ++i)
+    if (_arc_resolution > 0)
+      update_arc_table(i);
+  }
+}
+
+void HermiteSpline::update_around(size_t i)
+{
+  // Catmull-Rom tangents depend on the neighbours of a point, and segments on the tangents
+  // of their ends: an edit at i changes tangents i - 1 to i + 1, and segments i - 2 to i + 1.
+  size_t first = (i > 1) ? i - 2 : 0;
+  if (_auto_tangents)
   {
-    glm::vec3 P_t = Hermite<glm::vec3>(P0, P1, T0, T1, i * step);
-    length += (P_t - lastPt).length();
-    lastPt = P_t;
+    size_t last = std::min(i + 2, _points.size());
+    for (size_t k = (i > 0) ? i - 1 : 0; k < last; ++k)
+      _tangents[k] = catmull_rom_tangent(k);
   }
+  else if (i > 0)
+    first = i - 1;
 
-  return length;
+  update_segments(first, i + 2);
+  normalize_params();
+
+  // Renormalizing the params is linear anyway: the copies are rebuilt entirely
+  update_soa();
 }
 
-void HermiteSpline::update_params()
+void HermiteSpline::update_soa()
+{
+  if (_soa_storage)
+  {
+    _soa_points.assign(_points);
+    _soa_tangents.assign(_tangents);
+  }
+  else
+  {
+    _soa_points.clear();
+    _soa_tangents.clear();
+  }
+}
+
+void HermiteSpline::update_arc_table(size_t i)
 {
-  size_t nb_pts = _points.size();
-  _length = 0.0f;
+  size_t r = _arc_resolution;
+  float step = 1.0f / r;
 
-  // For each pair of consecutive points, we generate Hermite interpolated points.
-  // The length is then approximated to the length of the generated polyline.
-  std::vector<float> lengths;
-  for (size_t i = 1; i < nb_pts; ++i)
+  float* table = &_arc_table[i * (r + 1)];
+  table[0] = 0.0f;
+  for (size_t k = 0; k < r; ++k)
   {
-    if (glm::length(_points[i - 1] - _points[i]) != 0.0f)
-      _length += compute_length(_points[i - 1], _points[i], _tangents[i - 1], _tangents[i]);
-    lengths.push_back(_length);
+    table[k + 1] = table[k] + HermiteLength(_points[i], _points[i + 1], _tangents[i], _tangents[i + 1],
+                                            k * step, (k + 1) * step);
   }
+}
 
-  // Update params
-  _params.resize(nb_pts);
-  _params[0] = 0.0f;
-  for (size_t i = 0; i < lengths.size(); ++i)
-    _params[i + 1] = (lengths[i] / _length);
+void HermiteSpline::arc_length_params(const float* lengths, size_t count, float* params) const
+{
+  if (_arc_table.empty())
+  {
+    Curve::arc_length_params(lengths, count, params);
+    return;
+  }
+
+  size_t r = _arc_resolution;
+  float step = 1.0f / r;
+
+  size_t segment = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    // Params are proportional to the arc length at segment boundaries
+    float s = glm::clamp(lengths[i], 0.0f, 1.0f);
+    segment = find_segment(s, segment);
+
+    float p0 = _params[segment];
+    float p1 = _params[segment + 1];
+    const float* table = &_arc_table[segment * (r + 1)];
+    float target = glm::clamp((s - p0) / (p1 - p0), 0.0f, 1.0f) * table[r];
+
+    // Table lookup, then linear interpolation inside the table interval
+    size_t k = (std::upper_bound(table + 1, table + r, target) - table) - 1;
+    float tk = k * step;
+    float dk = table[k + 1] - table[k];
+    float t = tk + (dk > 0.0f ? (target - table[k]) / dk : 0.0f) * step;
+
+    // Newton refinement on the arc length from the start of the table interval
+    const glm::vec3& P0 = _points[segment];
+    const glm::vec3& P1 = _points[segment + 1];
+    const glm::vec3& T0 = _tangents[segment];
+    const glm::vec3& T1 = _tangents[segment + 1];
+    for (int it = 0; it < NEWTON_ITERATIONS; ++it)
+    {
+      float speed = glm::length(HermiteDerivative<glm::vec3>(P0, P1, T0, T1, t));
+      if (speed <= 0.0f)
+        break;
+
+      float error = table[k] + HermiteLength(P0, P1, T0, T1, tk, t) - target;
+      t = glm::clamp(t - error / speed, tk, tk + step);
+    }
+
+    params[i] = p0 + t * (p1 - p0);
+  }
+}
+
+void HermiteSpline::get_points(const float* params, size_t count, glm::vec3* points) const
+{
+  size_t segments[BATCH_SIZE];
+  float ts[BATCH_SIZE];
+  size_t segment = 0;
+  float h0[BATCH_SIZE], h1[BATCH_SIZE], h2[BATCH_SIZE], h3[BATCH_SIZE];
+  float xs[BATCH_SIZE], ys[BATCH_SIZE], zs[BATCH_SIZE];
+
+  for (size_t begin = 0; begin < count; begin += BATCH_SIZE)
+  {
+    size_t n = std::min(BATCH_SIZE, count - begin);
+    locate(params + begin, n, segments, ts, segment);
+    hermite_basis(ts, n, h0, h1, h2, h3);
+
+    glm::vec3* out = points + begin;
+    if (_soa_storage)
+    {
+      hermite_soa(_soa_points, _soa_tangents, segments, h0, h1, h2, h3, n, xs, ys, zs);
+
+      for (size_t i = 0; i < n; ++i)
+        out[i] = glm::vec3(xs[i], ys[i], zs[i]);
+    }
+    else
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        size_t k = segments[i];
+        out[i] = h0[i] * _points[k] + h1[i] * _tangents[k] + h2[i] * _points[k + 1] + h3[i] * _tangents[k + 1];
+      }
+    }
+  }
 }
 
-glm::vec3 HermiteSpline::get_point(float param)  
+void HermiteSpline::get_points(const float* params, size_t count, float* xs, float* ys, float* zs) const
 {
-  if (param <= 0.0f)
-    return _points.front();
-  if (param >= 1.0f)
-    return _points.back();
+  size_t segments[BATCH_SIZE];
+  float ts[BATCH_SIZE];
+  size_t segment = 0;
+  float h0[BATCH_SIZE], h1[BATCH_SIZE], h2[BATCH_SIZE], h3[BATCH_SIZE];
 
-  for (size_t i = 1; i < _params.size(); ++i)
+  for (size_t begin = 0; begin < count; begin += BATCH_SIZE)
   {
-    if (param < _params[i])
+    size_t n = std::min(BATCH_SIZE, count - begin);
+    locate(params + begin, n, segments, ts, segment);
+    hermite_basis(ts, n, h0, h1, h2, h3);
+
+    if (_soa_storage)
     {
-      float t = (param - _params[i - 1]) / (_params[i] - _params[i - 1]);
-      return Hermite<glm::vec3>(_points[i - 1], _points[i], _tangents[i - 1], _tangents[i], t);
+      hermite_soa(_soa_points, _soa_tangents, segments, h0, h1, h2, h3, n, xs + begin, ys + begin, zs + begin);
+    }
+    else
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        size_t k = segments[i];
+        glm::vec3 P = h0[i] * _points[k] + h1[i] * _tangents[k] + h2[i] * _points[k + 1] + h3[i] * _tangents[k + 1];
+        xs[begin + i] = P.x;
+        ys[begin + i] = P.y;
+        zs[begin + i] = P.z;
+      }
     }
   }
+}
 
-  // Should never be executed !
-  assert(false);
-  return glm::vec3();
+glm::vec3 HermiteSpline::get_derivative(float param) const
+{
+  glm::vec3 derivative;
+  get_derivatives(&param, 1, &derivative);
+  return derivative;
 }
 
-void HermiteSpline::catmull_rom_tangents(float c)
+glm::vec3 HermiteSpline::get_second_derivative(float param) const
 {
-  _tangents.resize(_points.size());
+  glm::vec3 derivative;
+  get_second_derivatives(&param, 1, &derivative);
+  return derivative;
+}
+
+void HermiteSpline::get_derivatives(const float* params, size_t count, glm::vec3* derivatives) const
+{
+  size_t segments[BATCH_SIZE];
+  float ts[BATCH_SIZE];
+  size_t segment = 0;
+
+  for (size_t begin = 0; begin < count; begin += BATCH_SIZE)
+  {
+    size_t n = std::min(BATCH_SIZE, count - begin);
+    locate(params + begin, n, segments, ts, segment);
 
-  // The way we compute tangent is different for first and last points
-  _tangents.front() = c * (_points[1] - _points[0]);
-  _tangents.back()  = c * (_points.back() - _points[_points.size() - 2]);
+    for (size_t i = 0; i < n; ++i)
+      derivatives[begin + i] = HermiteSplineDerivative(_points, _tangents, _params, segments[i], ts[i]);
+  }
+}
 
-  for (size_t i = 1; i < _points.size() - 1; ++i)
-    _tangents[i] = c * (_points[i + 1] - _points[i - 1]);
+void HermiteSpline::get_second_derivatives(const float* params, size_t count, glm::vec3* derivatives) const
+{
+  size_t segments[BATCH_SIZE];
+  float ts[BATCH_SIZE];
+  size_t segment = 0;
+
+  for (size_t begin = 0; begin < count; begin += BATCH_SIZE)
+  {
+    size_t n = std::min(BATCH_SIZE, count - begin);
+    locate(params + begin, n, segments, ts, segment);
+
+    for (size_t i = 0; i < n; ++i)
+      derivatives[begin + i] = HermiteSplineSecondDerivative(_points, _tangents, _params, segments[i], ts[i]);
+  }
+}
+
+AABB HermiteSpline::compute_segment_bounds(size_t i) const
+{
+  const glm::vec3& P0 = _points[i];
+  const glm::vec3& P1 = _points[i + 1];
+  const glm::vec3& T0 = _tangents[i];
+  const glm::vec3& T1 = _tangents[i + 1];
+
+  AABB bounds;
+  bounds.extend(P0);
+  bounds.extend(P1);
+
+  // Coefficients of the derivative a t^2 + b t + c (see HermiteDerivative)
+  glm::vec3 a = 3.0f * (T0 + T1) - 6.0f * (P1 - P0);
+  glm::vec3 b = 6.0f * (P1 - P0) - 4.0f * T0 - 2.0f * T1;
+  const glm::vec3& c = T0;
+
+  for (int k = 0; k < 3; ++k)
+  {
+    float roots[2];
+    int count = quadratic_roots(a[k], b[k], c[k], roots);
+    for (int r = 0; r < count; ++r)
+    {
+      if (roots[r] > 0.0f && roots[r] < 1.0f)
+        bounds.extend(Hermite<glm::vec3>(P0, P1, T0, T1, roots[r]));
+    }
+  }
+
+  return bounds;
+}
+
+std::vector<glm::vec3> HermiteSpline::resample_uniform(size_t count) const
+{
+  std::vector<glm::vec3> points(count);
+  float step = count > 1 ? 1.0f / (count - 1) : 0.0f;
+  size_t last = _params.size() - 2;
+
+  // Current point and its forward differences
+  glm::vec3 P, D1, D2, D3;
+
+  size_t segment = 0;
+  size_t steps = 0;
+  for (size_t j = 0; j < count; ++j)
+  {
+    float param = std::min(j * step, 1.0f);
+    if (j == 0 || steps == FORWARD_DIFFERENCES_STEPS || (segment < last && param >= _params[segment + 1]))
+    {
+      // The differences are computed from the polynomial form of the segment: a t^3 + b t^2 + c t + d
+      segment = find_segment(param, segment);
+      steps = 0;
+
+      const glm::vec3& P0 = _points[segment];
+      const glm::vec3& P1 = _points[segment + 1];
+      const glm::vec3& T0 = _tangents[segment];
+      const glm::vec3& T1 = _tangents[segment + 1];
+
+      glm::vec3 a = 2.0f * (P0 - P1) + T0 + T1;
+      glm::vec3 b = 3.0f * (P1 - P0) - 2.0f * T0 - T1;
+      glm::vec3 c = T0;
+
+      float width = _params[segment + 1] - _params[segment];
+      float t = (param - _params[segment]) / width;
+      float h = step / width;
+
+      P  = ((a * t + b) * t + c) * t + P0;
+      D1 = a * (3.0f * t * t * h + 3.0f * t * h * h + h * h * h) + b * (2.0f * t * h + h * h) + c * h;
+      D2 = a * (6.0f * t * h * h + 6.0f * h * h * h) + b * (2.0f * h * h);
+      D3 = a * (6.0f * h * h * h);
+    }
+    else
+    {
+      P  += D1;
+      D1 += D2;
+      D2 += D3;
+      ++steps;
+    }
+
+    points[j] = P;
+  }
+
+  // The last point is exact, as in get_point
+  if (count > 1)
+    points.back() = _points.back();
+
+  return points;
+}
+
+void HermiteSpline::catmull_rom_tangents(float c)
+{
+  _tangents.resize(_points.size());
+  for (size_t i = 0; i < _points.size(); ++i)
+    _tangents[i] = catmull_rom_tangent(i, c);
 }
 
-glm::vec3 HermiteSpline::hermite_tangent(const glm::vec3& P0, const glm::vec3& P1,
-                                  const glm::vec3& T0, const glm::vec3& T1,
-                                  float t) const
+glm::vec3 HermiteSpline::catmull_rom_tangent(size_t i, float c) const
 {
-  float t2 = t * t;
-  
-  // Hermite derivative values
-  float h0 = 6.0f * t * (t - 1.0f);
-  float h1 = 3.0f * t2 - 4.0f * t + 1.0f;
-  float h2 = 6.0f * t * (-t + 1.0f);
-  float h3 = 3.0f * t2 - 2.0f * t;
-  
-  return glm::normalize(h0 * P0 + h1 * T0 + h2 * P1 + h3 * T1);
+  return CatmullRomTangent(_points, i, c);
 }
@@ -4,30 +4,16 @@
 #include <memory>
 
 #include "Curve.h"
+#include "HermiteBasis.h"
+#include "SoAPoints.h"
+#include "SplineCore.h"
 
 
-template<typename T>
-T Hermite(const T& P0, const T& P1, const T& T0, const T& T1, float t)
-{
-    if (t <= 0.0f)
-        return P0;
-    if (t >= 1.0f)
-        return P1;
-
-    float t2 = t * t;
-    float t3 = t2 * t;
-
-    // Hermite basis functions
-    float h0 = 2.0f * t3 - 3.0f * t2 + 1.0f;
-    float h1 = t3 - 2.0f * t2 + t;
-    float h2 = -2.0f * t3 + 3.0f * t2;
-    float h3 = t3 - t2;
-
-    return h0 * P0 + h1 * T0 + h2 * P1 + h3 * T1;
-}
-
-
-class HermiteSpline : public Curve
+/**
+ * Hermite spline Curve, on float glm::vec3 points. Its evaluation core (see SplineCore.h) is shared
+ * with HermiteSplineT, which provides the same spline in other precisions and dimensions.
+ */
+class HermiteSpline final : public Curve
 {
 public:
     HermiteSpline();
@@ -35,17 +21,110 @@ public:
     HermiteSpline(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& tangents);
     void set_points(const std::vector<glm::vec3>& points) override ;
     void set_points_tangents(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& tangents);
-    glm::vec3 get_point(float param)  override;
+    const std::vector<glm::vec3>& get_tangents() const { return _tangents; }
+
+    /**
+     * With Catmull-Rom tangents (set_points), the tangents of the neighbours of the edited point are
+     * updated too. Tangents given to set_points_tangents are kept, and inserted points get a
+     * Catmull-Rom tangent.
+     */
+    void set_point(size_t i, const glm::vec3& point) override;
+    void insert_point(size_t i, const glm::vec3& point) override;
+    void remove_point(size_t i) override;
+
+    CurveKind kind() const override { return CurveKind::HERMITE; }
+
+    glm::vec3 get_point(float param) const override;
+    glm::vec3 get_point(float param, size_t& segment) const override;
+
+    using Curve::get_points;
+    void get_points(const float* params, size_t count, glm::vec3* points) const override;
+
+    /**
+     * Same as get_points, but writes each coordinate in a separate array: with the structure of
+     * arrays storage (see set_soa_storage), points are never interleaved.
+     */
+    void get_points(const float* params, size_t count, float* xs, float* ys, float* zs) const;
+
+    glm::vec3 get_derivative(float param) const override;
+    glm::vec3 get_second_derivative(float param) const override;
+    void get_derivatives(const float* params, size_t count, glm::vec3* derivatives) const override;
+    void get_second_derivatives(const float* params, size_t count, glm::vec3* derivatives) const override;
+
+    /**
+     * Steps through each segment with cubic forward differences (three additions per point).
+     */
+    std::vector<glm::vec3> resample_uniform(size_t count) const override;
+
+    /**
+     * Relative tolerance of the segment lengths integration (1e-4 by default).
+     * Changing it recomputes the params.
+     */
+    float get_length_tolerance() const { return _length_tolerance; }
+    void set_length_tolerance(float tolerance);
+
+    /**
+     * Number of samples per segment of the arc length table (0 by default, i.e. no table).
+     * The table is built with the params, and lets arc_length_params (so resample_arc_length)
+     * give points evenly spaced along the curve, including inside segments.
+     */
+    size_t get_arc_length_resolution() const { return _arc_resolution; }
+    void set_arc_length_resolution(size_t resolution);
+
+    void arc_length_params(const float* lengths, size_t count, float* params) const override;
+
+    /**
+     * Keeps a structure of arrays copy of the points and tangents (see SoAPoints), from which
+     * get_points evaluates each coordinate in a separate loop over aligned arrays.
+     * Disabled by default, as it doubles the memory used by the spline. Tests/SoAEvaluationBenchmark.cpp
+     * compares both storages: this one pays off on dense batches (many params per segment) compiled
+     * for wide vectors (AVX2 and up), not on sparse batches or with SSE2 only.
+     */
+    bool get_soa_storage() const { return _soa_storage; }
+    void set_soa_storage(bool enabled);
 
 private:
-    float compute_length(const glm::vec3& P0, const glm::vec3& P1, const glm::vec3& T0, const glm::vec3& T1) const;
+    /**
+     * Exact box of the segment: its end points, extended by the points where the derivative of
+     * a coordinate (a quadratic polynomial) vanishes.
+     */
+    AABB compute_segment_bounds(size_t i) const override;
 
     std::vector<glm::vec3> _tangents;
+    float _length_tolerance;
+
+    // For each segment, arc length from the segment start at t = k / _arc_resolution
+    std::vector<float> _arc_table;
+    size_t _arc_resolution;
+
+    // Are tangents computed from the points (Catmull-Rom) ?
+    bool _auto_tangents;
+
+    SoAPoints _soa_points;
+    SoAPoints _soa_tangents;
+    bool _soa_storage;
+
     void update_params();
+    void update_segments(size_t first, size_t last);
+    void update_around(size_t i);
+    void update_arc_table(size_t i);
+    void update_soa();
     void catmull_rom_tangents(float c = 0.5f);
-    glm::vec3 hermite_tangent(const glm::vec3& P0, const glm::vec3& P1, const glm::vec3& T0, const glm::vec3& T1, float t) const;
+    glm::vec3 catmull_rom_tangent(size_t i, float c = 0.5f) const;
 };
 
+// get_point is inline: callers knowing the concrete type (see CurveDispatch.h) can inline it
+inline glm::vec3 HermiteSpline::get_point(float param) const
+{
+    size_t segment = 0;
+    return get_point(param, segment);
+}
+
+inline glm::vec3 HermiteSpline::get_point(float param, size_t& segment) const
+{
+    return HermiteSplinePoint(_points, _tangents, _params, param, segment);
+}
+
 using HermiteSplinePtr = std::shared_ptr<HermiteSpline>;
 
 #endif // HERMITE_SPLINE_H_
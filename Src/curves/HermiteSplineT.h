@@ -0,0 +1,193 @@
+#ifndef __HERMITE_SPLINE_T_H__
+#define __HERMITE_SPLINE_T_H__
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "curves/SplineCore.h"
+
+
+/**
+ * Hermite spline on points of type V, a glm vector of the scalar type S: double precision for
+ * long strokes, whose params lose precision in float, or 2D points for sketches.
+ * It runs the evaluation core of HermiteSpline (see SplineCore.h): same Catmull-Rom tangents, arc
+ * length params, segment search and kernels, so HermiteSplineT<float, glm::vec3> evaluates
+ * exactly like HermiteSpline. It is not a Curve, as curves are float and 3D: editing, arc length
+ * tables and the structure of arrays storage are only provided by HermiteSpline.
+ */
+template<typename S, typename V>
+class HermiteSplineT
+{
+public:
+    using Scalar = S;
+    using Vector = V;
+
+    HermiteSplineT() : _length(0), _length_tolerance(S(1e-4)) {}
+    HermiteSplineT(const std::vector<V>& points) : _length_tolerance(S(1e-4)) { set_points(points); }
+    HermiteSplineT(const std::vector<V>& points, const std::vector<V>& tangents)
+        : _length_tolerance(S(1e-4))
+    {
+        set_points_tangents(points, tangents);
+    }
+
+    /**
+     * Sets the points, with Catmull-Rom tangents
+     */
+    void set_points(const std::vector<V>& points);
+    void set_points_tangents(const std::vector<V>& points, const std::vector<V>& tangents);
+
+    const std::vector<V>& getControlPoints() const { return _points; }
+    const std::vector<V>& get_tangents() const { return _tangents; }
+    const std::vector<S>& get_params() const { return _params; }
+    const std::vector<S>& get_lengths() const { return _lengths; }
+    S get_length() const { return _length; }
+
+    /**
+     * Relative tolerance of the segment lengths integration (1e-4 by default, as HermiteSpline).
+     * Changing it recomputes the params.
+     */
+    S get_length_tolerance() const { return _length_tolerance; }
+    void set_length_tolerance(S tolerance) { _length_tolerance = tolerance; update_params(); }
+
+    /**
+     * See Curve::get_point: params outside of [0, 1] are clamped, and segment is the hint and
+     * result of the segment search
+     */
+    V get_point(S param) const { size_t segment = 0; return get_point(param, segment); }
+    V get_point(S param, size_t& segment) const { return HermiteSplinePoint(_points, _tangents, _params, param, segment); }
+
+    /**
+     * Sorted params are evaluated in a single pass over the segments
+     */
+    void get_points(const S* params, size_t count, V* points) const;
+    std::vector<V> get_points(const std::vector<S>& params) const;
+
+    V get_derivative(S param) const;
+    V get_second_derivative(S param) const;
+
+    size_t find_segment(S param, size_t hint = 0) const { return FindSegment(_params, param, hint); }
+
+private:
+    void update_params();
+
+    /**
+     * Segment and local parameter of param (clamped to [0, 1]), see Curve::locate
+     */
+    size_t locate(S param, size_t segment, S& t) const;
+
+    std::vector<V> _points;
+    std::vector<V> _tangents;
+    std::vector<S> _lengths;
+    std::vector<S> _params;
+    S _length;
+    S _length_tolerance;
+};
+
+using HermiteSpline2f = HermiteSplineT<float, glm::vec2>;
+using HermiteSpline3f = HermiteSplineT<float, glm::vec3>;
+using HermiteSpline2d = HermiteSplineT<double, glm::dvec2>;
+using HermiteSpline3d = HermiteSplineT<double, glm::dvec3>;
+
+template<typename S, typename V>
+using HermiteSplineTPtr = std::shared_ptr<HermiteSplineT<S, V>>;
+
+
+template<typename S, typename V>
+void HermiteSplineT<S, V>::set_points(const std::vector<V>& points)
+{
+    assert(points.size() != 0);
+
+    std::vector<V> tangents(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+        tangents[i] = CatmullRomTangent(points, i, S(0.5));
+
+    set_points_tangents(points, tangents);
+}
+
+template<typename S, typename V>
+void HermiteSplineT<S, V>::set_points_tangents(const std::vector<V>& points, const std::vector<V>& tangents)
+{
+    assert(points.size() != 0);
+    assert(points.size() == tangents.size());
+    _points = points;
+    _tangents = tangents;
+
+    update_params();
+}
+
+template<typename S, typename V>
+void HermiteSplineT<S, V>::update_params()
+{
+    _lengths.resize(_points.size() - 1);
+    for (size_t i = 0; i < _lengths.size(); ++i)
+        _lengths[i] = HermiteSegmentLength(_points, _tangents, i, _length_tolerance);
+
+    _length = NormalizeParams(_lengths, _params);
+}
+
+template<typename S, typename V>
+size_t HermiteSplineT<S, V>::locate(S param, size_t segment, S& t) const
+{
+    param = glm::clamp(param, S(0), S(1));
+
+    // Coherent params mostly stay in the segment of the previous one
+    if (param < _params[segment] || param >= _params[segment + 1])
+        segment = find_segment(param, segment);
+
+    t = SegmentParam(_params, segment, param);
+    return segment;
+}
+
+template<typename S, typename V>
+void HermiteSplineT<S, V>::get_points(const S* params, size_t count, V* points) const
+{
+    if (_points.size() == 1)
+    {
+        std::fill(points, points + count, _points.front());
+        return;
+    }
+
+    size_t segment = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        S t;
+        segment = locate(params[i], segment, t);
+        points[i] = Hermite<V, S>(_points[segment], _points[segment + 1], _tangents[segment], _tangents[segment + 1], t);
+    }
+}
+
+template<typename S, typename V>
+std::vector<V> HermiteSplineT<S, V>::get_points(const std::vector<S>& params) const
+{
+    std::vector<V> points(params.size());
+    get_points(params.data(), params.size(), points.data());
+    return points;
+}
+
+template<typename S, typename V>
+V HermiteSplineT<S, V>::get_derivative(S param) const
+{
+    if (_points.size() == 1)
+        return V(S(0));
+
+    S t;
+    size_t i = locate(param, 0, t);
+    return HermiteSplineDerivative(_points, _tangents, _params, i, t);
+}
+
+template<typename S, typename V>
+V HermiteSplineT<S, V>::get_second_derivative(S param) const
+{
+    if (_points.size() == 1)
+        return V(S(0));
+
+    S t;
+    size_t i = locate(param, 0, t);
+    return HermiteSplineSecondDerivative(_points, _tangents, _params, i, t);
+}
+
+#endif // __HERMITE_SPLINE_T_H__
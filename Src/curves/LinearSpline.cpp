@@ -1,6 +1,9 @@
 
 #include "LinearSpline.h"
 
+#include <algorithm>
+#include <cassert>
+
 LinearSpline::LinearSpline()
   : Curve()
 {}
@@ -18,41 +21,90 @@ void LinearSpline::set_points(const std::vector<glm::vec3>& controlPoints)
 }
 
 
+void LinearSpline::set_point(size_t i, const glm::vec3& point)
+{
+  _points[i] = point;
+
+  updateLengths(i > 0 ? i - 1 : 0, i + 1);
+  normalize_params();
+}
+
+void LinearSpline::insert_point(size_t i, const glm::vec3& point)
+{
+  _points.insert(_points.begin() + i, point);
+  _lengths.insert(_lengths.begin() + std::min(i, _lengths.size()), 0.0f);
+
+  updateLengths(i > 0 ? i - 1 : 0, i + 1);
+  normalize_params();
+}
+
+void LinearSpline::remove_point(size_t i)
+{
+  assert(_points.size() > 2);
+
+  _points.erase(_points.begin() + i);
+  _lengths.erase(_lengths.begin() + std::min(i, _lengths.size() - 1));
+
+  updateLengths(i > 0 ? i - 1 : 0, i);
+  normalize_params();
+}
+
+
 void LinearSpline::updateParams()
 {
-  float length = 0.0f;
-  for (size_t i = 1; i < _points.size(); ++i)
-    length += glm::length(_points[i] - _points[i - 1]);
+  _lengths.resize(_points.size() > 0 ? _points.size() - 1 : 0);
+  updateLengths(0, _lengths.size());
+  normalize_params();
+}
+
+void LinearSpline::updateLengths(size_t first, size_t last)
+{
+  last = std::min(last, _lengths.size());
+  for (size_t i = first; i < last; ++i)
+    _lengths[i] = glm::length(_points[i + 1] - _points[i]);
+}
 
-  _params.clear();
-  float dist = 0.0f;
+void LinearSpline::get_points(const float* params, size_t count, glm::vec3* points) const
+{
+  size_t segments[BATCH_SIZE];
+  float ts[BATCH_SIZE];
+  size_t segment = 0;
 
-  _params.push_back(0.0f);
-  for (size_t i = 1; i < _points.size() - 1; ++i)
+  for (size_t begin = 0; begin < count; begin += BATCH_SIZE)
   {
-    dist += glm::length(_points[i] - _points[i - 1]);
-    _params.push_back(dist / length);
+    size_t n = std::min(BATCH_SIZE, count - begin);
+    locate(params + begin, n, segments, ts, segment);
+
+    glm::vec3* out = points + begin;
+    for (size_t i = 0; i < n; ++i)
+    {
+      size_t k = segments[i];
+      out[i] = glm::mix(_points[k], _points[k + 1], ts[i]);
+    }
   }
-  _params.push_back(1.0f);
 }
 
-glm::vec3 LinearSpline::get_point(float param)  
+glm::vec3 LinearSpline::get_derivative(float param) const
 {
-  if (param <= 0.0f)
-    return _points.front();
-  if (param >= 1.0f)
-    return _points.back();
+  glm::vec3 derivative;
+  get_derivatives(&param, 1, &derivative);
+  return derivative;
+}
 
-  for (size_t i = 1; i < _points.size(); ++i)
+void LinearSpline::get_derivatives(const float* params, size_t count, glm::vec3* derivatives) const
+{
+  size_t segment = 0;
+  for (size_t i = 0; i < count; ++i)
   {
-    if (param < _params[i])
-    {
-      float t = (param - _params[i - 1]) / (_params[i] - _params[i - 1]);
-      return glm::mix(_points[i - 1], _points[i], t);//<glm::vec3, float>
-    }
+    segment = find_segment(glm::clamp(params[i], 0.0f, 1.0f), segment);
+
+    // Coincident points give a segment of null width, on which the curve does not move
+    float width = _params[segment + 1] - _params[segment];
+    derivatives[i] = (width > 0.0f) ? (_points[segment + 1] - _points[segment]) / width : glm::vec3(0.0f);
   }
+}
 
-  // Should never be executed !
-  assert(false);
-  return glm::vec3();
+void LinearSpline::get_second_derivatives(const float* /*params*/, size_t count, glm::vec3* derivatives) const
+{
+  std::fill(derivatives, derivatives + count, glm::vec3(0.0f));
 }
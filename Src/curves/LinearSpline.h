@@ -6,19 +6,61 @@
 #include "Curve.h"
 
 
-class LinearSpline : public Curve
+class LinearSpline final : public Curve
 {
 public:
     LinearSpline();
     LinearSpline(const std::vector<glm::vec3>&  points);
 
     void set_points(const std::vector<glm::vec3>& controlPoints) override;
-    glm::vec3 get_point(float param) override;
+
+    void set_point(size_t i, const glm::vec3& point) override;
+    void insert_point(size_t i, const glm::vec3& point) override;
+    void remove_point(size_t i) override;
+
+    CurveKind kind() const override { return CurveKind::LINEAR; }
+
+    glm::vec3 get_point(float param) const override;
+    glm::vec3 get_point(float param, size_t& segment) const override;
+
+    using Curve::get_points;
+    void get_points(const float* params, size_t count, glm::vec3* points) const override;
+
+    /**
+     * Derivatives are constant on each segment (null on segments of null length), and second
+     * derivatives are null.
+     */
+    glm::vec3 get_derivative(float param) const override;
+    glm::vec3 get_second_derivative(float /*param*/) const override { return glm::vec3(0.0f); }
+    void get_derivatives(const float* params, size_t count, glm::vec3* derivatives) const override;
+    void get_second_derivatives(const float* params, size_t count, glm::vec3* derivatives) const override;
 
 private:
     void updateParams();
+    void updateLengths(size_t first, size_t last);
 };
 
+// get_point is inline: callers knowing the concrete type (see CurveDispatch.h) can inline it
+inline glm::vec3 LinearSpline::get_point(float param) const
+{
+    size_t segment = 0;
+    return get_point(param, segment);
+}
+
+inline glm::vec3 LinearSpline::get_point(float param, size_t& segment) const
+{
+    if (param <= 0.0f)
+        return _points.front();
+    if (param >= 1.0f)
+        return _points.back();
+
+    size_t i = find_segment(param, segment);
+    segment = i;
+
+    float t = (param - _params[i]) / (_params[i + 1] - _params[i]);
+    return glm::mix(_points[i], _points[i + 1], t);
+}
+
 using LinearSplinePtr = std::shared_ptr<LinearSpline>;
 
 
@@ -0,0 +1,38 @@
+#include "curves/SoAPoints.h"
+
+#include <algorithm>
+
+
+const size_t SoAPoints::PADDING;
+
+
+void SoAPoints::assign(const std::vector<glm::vec3>& points)
+{
+  _size = points.size();
+  if (_size == 0)
+  {
+    clear();
+    return;
+  }
+
+  size_t padded = (_size + PADDING - 1) / PADDING * PADDING;
+  _x.resize(padded);
+  _y.resize(padded);
+  _z.resize(padded);
+
+  for (size_t i = 0; i < padded; ++i)
+  {
+    const glm::vec3& P = points[std::min(i, _size - 1)];
+    _x[i] = P.x;
+    _y[i] = P.y;
+    _z[i] = P.z;
+  }
+}
+
+void SoAPoints::clear()
+{
+  _x.clear();
+  _y.clear();
+  _z.clear();
+  _size = 0;
+}
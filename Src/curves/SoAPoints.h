@@ -0,0 +1,43 @@
+#ifndef __SOA_POINTS_H__
+#define __SOA_POINTS_H__
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "utils/AlignedAllocator.h"
+
+
+/**
+ * Structure of arrays copy of a vector of points: one array per coordinate, aligned on 64 bytes
+ * (a cache line, and the width of AVX-512 registers). Arrays are padded to a multiple of PADDING
+ * floats with copies of the last point, so that kernels can process whole vectors, and read the
+ * point after any valid index but the last one.
+ */
+class SoAPoints
+{
+public:
+    static const size_t PADDING = 16;
+
+    SoAPoints() : _size(0) {}
+
+    void assign(const std::vector<glm::vec3>& points);
+    void clear();
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    const float* x() const { return _x.data(); }
+    const float* y() const { return _y.data(); }
+    const float* z() const { return _z.data(); }
+
+    glm::vec3 operator[](size_t i) const { return glm::vec3(_x[i], _y[i], _z[i]); }
+
+private:
+    AlignedVector<float> _x;
+    AlignedVector<float> _y;
+    AlignedVector<float> _z;
+    size_t _size;
+};
+
+#endif // __SOA_POINTS_H__
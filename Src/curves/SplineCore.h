@@ -0,0 +1,156 @@
+#ifndef __SPLINE_CORE_H__
+#define __SPLINE_CORE_H__
+
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "curves/HermiteBasis.h"
+
+
+/**
+ * Evaluation core of the splines, templated on the scalar type S of the params and the type V of
+ * the points (a glm vector of S). Curve, HermiteSpline and LinearSpline run it on their float
+ * glm::vec3 arrays, and HermiteSplineT on points of any precision and dimension.
+ * Segment i spans [params[i], params[i + 1]], from point i to point i + 1.
+ */
+
+
+/**
+ * Index of the segment containing param, see Curve::find_segment
+ */
+template<typename S>
+size_t FindSegment(const std::vector<S>& params, S param, size_t hint)
+{
+    size_t last = params.size() - 2;
+    hint = std::min(hint, last);
+
+    // Binary search before the hint: the first param strictly greater than param ends the segment
+    if (param < params[hint])
+    {
+        auto it = std::upper_bound(params.begin() + 1, params.begin() + hint + 1, param);
+        return (it - params.begin()) - 1;
+    }
+
+    // Exponential search after the hint: coherent queries stop after the first steps
+    size_t lo = hint;
+    size_t step = 1;
+    while (lo + step <= last && params[lo + step] <= param)
+    {
+        lo += step;
+        step *= 2;
+    }
+
+    auto it = std::upper_bound(params.begin() + lo + 1, params.begin() + std::min(lo + step, last + 1), param);
+    return (it - params.begin()) - 1;
+}
+
+/**
+ * Local parameter in [0, 1] of param within segment i. Segments of null width (between
+ * coincident points) return 0.
+ */
+template<typename S>
+S SegmentParam(const std::vector<S>& params, size_t i, S param)
+{
+    S width = params[i + 1] - params[i];
+    return (width > S(0)) ? glm::clamp((param - params[i]) / width, S(0), S(1)) : S(0);
+}
+
+/**
+ * Computes the params from the segment lengths: they are proportional to the arc length, or
+ * uniform if the length is null. Returns the length.
+ */
+template<typename S>
+S NormalizeParams(const std::vector<S>& lengths, std::vector<S>& params)
+{
+    // Lengths are accumulated in double precision, so that long curves keep accurate params
+    double length = 0.0;
+    for (S segmentLength : lengths)
+        length += segmentLength;
+
+    params.resize(lengths.size() + 1);
+    params[0] = S(0);
+
+    double distance = 0.0;
+    for (size_t i = 0; i < lengths.size(); ++i)
+    {
+        distance += lengths[i];
+        params[i + 1] = (length > 0.0) ? (S)(distance / length) : (S)(i + 1) / lengths.size();
+    }
+
+    return (S)length;
+}
+
+
+/**
+ * Catmull-Rom tangent of point i: c times the difference of its neighbours, one-sided at the ends
+ */
+template<typename V, typename S>
+V CatmullRomTangent(const std::vector<V>& points, size_t i, S c)
+{
+    size_t previous = (i > 0) ? i - 1 : 0;
+    size_t next = std::min(i + 1, points.size() - 1);
+    return c * (points[next] - points[previous]);
+}
+
+/**
+ * Length of the Hermite segment i, integrated from its derivative (see HermiteAdaptiveLength) with
+ * the relative tolerance. Segments between coincident points have a null length.
+ */
+template<typename V, typename S>
+S HermiteSegmentLength(const std::vector<V>& points, const std::vector<V>& tangents, size_t i, S tolerance)
+{
+    // Maximum number of bisections of a quarter of the segment
+    const int MAX_LENGTH_DEPTH = 8;
+
+    if (points[i + 1] == points[i])
+        return S(0);
+
+    return HermiteAdaptiveLength<V, S>(points[i], points[i + 1], tangents[i], tangents[i + 1], tolerance,
+                                       MAX_LENGTH_DEPTH);
+}
+
+/**
+ * Hermite spline at param, see Curve::get_point: params outside of ]0, 1[ give the end points,
+ * and segment is the hint and the result of the segment search.
+ */
+template<typename V, typename S>
+V HermiteSplinePoint(const std::vector<V>& points, const std::vector<V>& tangents, const std::vector<S>& params,
+                     S param, size_t& segment)
+{
+    if (param <= S(0) || points.size() == 1)
+        return points.front();
+    if (param >= S(1))
+        return points.back();
+
+    size_t i = FindSegment(params, param, segment);
+    segment = i;
+
+    return Hermite<V, S>(points[i], points[i + 1], tangents[i], tangents[i + 1], SegmentParam(params, i, param));
+}
+
+/**
+ * Derivatives of the Hermite spline with respect to the param, at the local parameter t of
+ * segment i: the derivatives with respect to t, divided by the width of the segment (squared for
+ * the second derivative). The curve does not move on segments of null width, where they are null.
+ */
+template<typename V, typename S>
+V HermiteSplineDerivative(const std::vector<V>& points, const std::vector<V>& tangents, const std::vector<S>& params,
+                          size_t i, S t)
+{
+    S width = params[i + 1] - params[i];
+    V D = HermiteDerivative<V, S>(points[i], points[i + 1], tangents[i], tangents[i + 1], t);
+    return (width > S(0)) ? D / width : V(S(0));
+}
+
+template<typename V, typename S>
+V HermiteSplineSecondDerivative(const std::vector<V>& points, const std::vector<V>& tangents,
+                                const std::vector<S>& params, size_t i, S t)
+{
+    S width = params[i + 1] - params[i];
+    V D = HermiteSecondDerivative<V, S>(points[i], points[i + 1], tangents[i], tangents[i + 1], t);
+    return (width > S(0)) ? D / (width * width) : V(S(0));
+}
+
+#endif // __SPLINE_CORE_H__
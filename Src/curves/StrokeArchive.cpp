@@ -0,0 +1,203 @@
+#include "curves/StrokeArchive.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+
+static uint16_t quantize(float value)
+{
+  return (uint16_t)std::lround(glm::clamp(value, 0.0f, 65535.0f));
+}
+
+
+const size_t StrokeArchive::CHECKPOINT_INTERVAL;
+
+StrokeArchive::StrokeArchive()
+  : _point_count(0)
+  , _max_error(0.0f)
+{}
+
+void StrokeArchive::reserve(size_t strokes, size_t points)
+{
+  _strokes.reserve(strokes);
+  _positions.reserve(3 * points);
+  _checkpoints.reserve(points / CHECKPOINT_INTERVAL + 1);
+}
+
+void StrokeArchive::clear()
+{
+  _strokes.clear();
+  _positions.clear();
+  _checkpoints.clear();
+  _point_count = 0;
+  _max_error = 0.0f;
+}
+
+void StrokeArchive::shrink_to_fit()
+{
+  _strokes.shrink_to_fit();
+  _positions.shrink_to_fit();
+  _checkpoints.shrink_to_fit();
+}
+
+
+size_t StrokeArchive::add(const std::vector<glm::vec3>& points)
+{
+  assert(points.size() != 0);
+  assert(points.size() <= std::numeric_limits<uint32_t>::max());
+
+  Stroke stroke;
+  stroke.first = _point_count;
+  stroke.count = (uint32_t)points.size();
+
+  glm::vec3 min = points.front();
+  glm::vec3 max = points.front();
+  for (const glm::vec3& P : points)
+  {
+    min = glm::min(min, P);
+    max = glm::max(max, P);
+  }
+  stroke.origin = min;
+  stroke.scale = (max - min) / 65535.0f;
+
+  for (const glm::vec3& P : points)
+  {
+    for (int c = 0; c < 3; ++c)
+      _positions.push_back(stroke.scale[c] > 0.0f ? quantize((P[c] - min[c]) / stroke.scale[c]) : 0);
+  }
+  _point_count += points.size();
+
+  // Accumulated in the same order as in get_points, so that the last param reaches the end, and
+  // that walking from a checkpoint gives the same distances as walking from the first point
+  stroke.length = 0.0f;
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    if ((stroke.first + i) % CHECKPOINT_INTERVAL == 0)
+      _checkpoints.push_back(stroke.length);
+    if (i + 1 < points.size())
+      stroke.length += glm::length(point(stroke, i + 1) - point(stroke, i));
+  }
+
+  for (size_t i = 0; i < points.size(); ++i)
+    _max_error = std::max(_max_error, glm::length(point(stroke, i) - points[i]));
+
+  _strokes.push_back(stroke);
+  return _strokes.size() - 1;
+}
+
+
+glm::vec3 StrokeArchive::point(const Stroke& stroke, size_t i) const
+{
+  const uint16_t* q = &_positions[3 * (stroke.first + i)];
+  return stroke.origin + stroke.scale * glm::vec3(q[0], q[1], q[2]);
+}
+
+glm::vec3 StrokeArchive::get_control_point(size_t stroke, size_t i) const
+{
+  return point(_strokes[stroke], i);
+}
+
+std::vector<glm::vec3> StrokeArchive::get_control_points(size_t stroke) const
+{
+  const Stroke& s = _strokes[stroke];
+
+  std::vector<glm::vec3> points(s.count);
+  for (size_t i = 0; i < s.count; ++i)
+    points[i] = point(s, i);
+
+  return points;
+}
+
+
+glm::vec3 StrokeArchive::get_point(size_t stroke, float param) const
+{
+  glm::vec3 point;
+  get_points(stroke, &param, 1, &point);
+  return point;
+}
+
+void StrokeArchive::get_points(size_t stroke, const float* params, size_t count, glm::vec3* points) const
+{
+  const Stroke& s = _strokes[stroke];
+  if (s.count == 1 || s.length == 0.0f)
+  {
+    std::fill(points, points + count, point(s, 0));
+    return;
+  }
+
+  // Checkpoints of the points starting a segment: [firstCheckpoint, lastCheckpoint[
+  size_t firstCheckpoint = (s.first + CHECKPOINT_INTERVAL - 1) / CHECKPOINT_INTERVAL;
+  size_t lastCheckpoint = (s.first + s.count - 2) / CHECKPOINT_INTERVAL + 1;
+
+  // Current segment, and distance along the polyline at its start
+  size_t segment = 0;
+  float start = 0.0f;
+  glm::vec3 P0 = point(s, 0);
+  glm::vec3 P1 = point(s, 1);
+  float length = glm::length(P1 - P0);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    float distance = glm::clamp(params[i], 0.0f, 1.0f) * s.length;
+
+    // Params outside of the current segment start from the last point before them with a
+    // checkpoint (or the first point), unless it is behind the current segment
+    if (distance < start || distance >= start + length)
+    {
+      auto it = std::upper_bound(_checkpoints.begin() + firstCheckpoint, _checkpoints.begin() + lastCheckpoint, distance);
+      size_t next = 0;
+      float nextStart = 0.0f;
+      if (it != _checkpoints.begin() + firstCheckpoint)
+      {
+        --it;
+        next = (it - _checkpoints.begin()) * CHECKPOINT_INTERVAL - s.first;
+        nextStart = *it;
+      }
+
+      if (distance < start || next > segment)
+      {
+        segment = next;
+        start = nextStart;
+        P0 = point(s, segment);
+        P1 = point(s, segment + 1);
+        length = glm::length(P1 - P0);
+      }
+    }
+
+    while (distance >= start + length && segment + 2 < s.count)
+    {
+      ++segment;
+      start += length;
+      P0 = P1;
+      P1 = point(s, segment + 1);
+      length = glm::length(P1 - P0);
+    }
+
+    float t = (length > 0.0f) ? glm::clamp((distance - start) / length, 0.0f, 1.0f) : 0.0f;
+    points[i] = glm::mix(P0, P1, t);
+  }
+}
+
+
+LinearSplinePtr StrokeArchive::inflate(size_t stroke) const
+{
+  return std::make_shared<LinearSpline>(get_control_points(stroke));
+}
+
+
+size_t StrokeArchive::memory_usage() const
+{
+  return sizeof(*this) + _strokes.capacity() * sizeof(Stroke) + _positions.capacity() * sizeof(uint16_t) +
+         _checkpoints.capacity() * sizeof(float);
+}
+
+size_t StrokeArchive::spline_memory_usage() const
+{
+  // LinearSpline object and shared_ptr control block (make_shared), then the point, segment
+  // length and param of each point
+  size_t memory = _strokes.size() * (sizeof(LinearSpline) + 2 * sizeof(long) + sizeof(LinearSplinePtr));
+  memory += _point_count * (sizeof(glm::vec3) + 2 * sizeof(float));
+  return memory;
+}
@@ -0,0 +1,107 @@
+#ifndef __STROKE_ARCHIVE_H__
+#define __STROKE_ARCHIVE_H__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "curves/LinearSpline.h"
+
+
+/**
+ * Compact, read-only storage of many polyline strokes, e.g. captured datasets kept in memory.
+ * All the strokes share two contiguous arrays (no allocation per stroke), and positions are
+ * quantized on 16 bits per coordinate within the bounding box of their stroke.
+ * Params are not stored: as in LinearSpline, they are proportional to the distance along the
+ * polyline, so they are recomputed from the quantized points while walking the segments.
+ * A point takes 6 bytes instead of 20 in a LinearSpline (point, segment length and param), plus
+ * a distance along its stroke every CHECKPOINT_INTERVAL points, and a stroke 40 bytes instead of
+ * the LinearSpline object, its shared_ptr and its vectors.
+ * The quantization error on the points is tracked when strokes are added (see max_error).
+ */
+class StrokeArchive
+{
+public:
+    StrokeArchive();
+
+    void reserve(size_t strokes, size_t points);
+    void clear();
+
+    /**
+     * Adds a stroke going through the given points, and returns its index
+     */
+    size_t add(const std::vector<glm::vec3>& points);
+    size_t add(const Curve& curve) { return add(curve.getControlPoints()); }
+
+    size_t size() const { return _strokes.size(); }
+    size_t point_count(size_t stroke) const { return _strokes[stroke].count; }
+
+    glm::vec3 get_control_point(size_t stroke, size_t i) const;
+    std::vector<glm::vec3> get_control_points(size_t stroke) const;
+
+    /**
+     * Evaluation of a stroke at a param in [0, 1] (clamped), as LinearSpline::get_point.
+     * The segment of a param is found by a binary search on the checkpoints of the stroke, then
+     * by walking at most CHECKPOINT_INTERVAL segments. Sorted params are evaluated in a single
+     * pass over the segments.
+     */
+    glm::vec3 get_point(size_t stroke, float param) const;
+    void get_points(size_t stroke, const float* params, size_t count, glm::vec3* points) const;
+
+    /**
+     * Bounding box of a stroke
+     */
+    glm::vec3 get_min(size_t stroke) const { return _strokes[stroke].origin; }
+    glm::vec3 get_max(size_t stroke) const { return _strokes[stroke].origin + 65535.0f * _strokes[stroke].scale; }
+
+    /**
+     * Decompresses a stroke, for the code working on Curve objects
+     */
+    LinearSplinePtr inflate(size_t stroke) const;
+
+    /**
+     * Largest distance between a point given to add and its quantized value.
+     * Params computed from the quantized points also shift slightly along the stroke, so the
+     * distance to the exact stroke evaluated at the same param can be a few times larger.
+     */
+    float max_error() const { return _max_error; }
+
+    /**
+     * Memory used by the archive, and by the same strokes stored as LinearSpline objects
+     * (without the allocator overhead).
+     * shrink_to_fit releases the memory reserved for strokes added later.
+     */
+    size_t memory_usage() const;
+    size_t spline_memory_usage() const;
+    void shrink_to_fit();
+
+private:
+    struct Stroke
+    {
+        uint64_t first;  // Index of the first point in _positions
+        glm::vec3 origin;
+        glm::vec3 scale; // Size of a quantization step on each axis
+        float length;    // Length of the quantized polyline
+        uint32_t count;
+    };
+
+    /**
+     * Points whose index (in the whole archive) is a multiple of CHECKPOINT_INTERVAL have their
+     * distance along their stroke stored in _checkpoints[index / CHECKPOINT_INTERVAL]
+     */
+    static const size_t CHECKPOINT_INTERVAL = 32;
+
+    glm::vec3 point(const Stroke& stroke, size_t i) const;
+
+    std::vector<Stroke> _strokes;
+    std::vector<uint16_t> _positions; // x, y, z of each point
+    std::vector<float> _checkpoints;
+    size_t _point_count;
+    float _max_error;
+};
+
+using StrokeArchivePtr = std::shared_ptr<StrokeArchive>;
+
+#endif // __STROKE_ARCHIVE_H__
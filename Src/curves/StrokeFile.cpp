@@ -0,0 +1,545 @@
+#include "curves/StrokeFile.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "curves/HermiteSpline.h"
+#include "curves/LinearSpline.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPool.h"
+
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Payloads are read as arrays of glm::vec3");
+
+static const char MAGIC[4] = { 'S', 'T', 'R', 'K' };
+
+static const uint32_t HAS_TANGENTS = 1;
+
+static const size_t PAYLOAD_ALIGNMENT = 16;
+
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t strokeCount;
+    uint32_t reserved;
+};
+
+
+// Text files are parsed in parallel by chunks of about this size
+static const size_t TEXT_CHUNK_SIZE = 4 << 20;
+
+// Malformed lines logged individually by readText
+static const size_t MAX_LOGGED_LINES = 10;
+
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Is d exactly halfway between f, the float nearest to it, and the next float away from f ?
+ */
+static bool isFloatMidpoint(double d, float f)
+{
+    // In the range of normal floats, a double is halfway between two floats when the 29 bits of
+    // its mantissa past the 23 of a float are 100...0
+    if (std::fabs(d) >= FLT_MIN)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return (bits & 0x1FFFFFFFull) == 0x10000000ull;
+    }
+
+    if (d == (double)f)
+        return false;
+
+    float next = std::nextafter(f, (d > f) ? INFINITY : -INFINITY);
+    return d - (double)f == (double)next - d;
+}
+
+/**
+ * strtof of the decimal number made of the digits (and decimal point) in [begin, end[ times
+ * 10^power. strtof needs a null terminated string, and its decimal point depends on the locale:
+ * the digits are copied without the point, which is moved to the exponent.
+ */
+static float parseDigits(const char* begin, const char* end, int power)
+{
+    std::string token;
+    bool fraction = false;
+    for (const char* c = begin; c < end; ++c)
+    {
+        if (*c == '.')
+            fraction = true;
+        else
+        {
+            token += *c;
+            if (fraction)
+                --power;
+        }
+    }
+    token += 'e' + std::to_string(power);
+
+    return std::strtof(token.c_str(), nullptr);
+}
+
+/**
+ * Parses the float following p (after blanks) and moves p after it, as strtof but without
+ * reading past end nor depending on the locale.
+ * Decimal numbers are rounded once, as by strtof. Up to 7 significant digits and exponents up
+ * to 10, the mantissa and the power of ten are exact floats, and are multiplied in float. Up to
+ * 15 digits and exponents up to 22, they are multiplied in double: rounding this double to float
+ * only differs from rounding the exact value when it lies exactly halfway between two floats.
+ * Other decimal numbers (and those halfway cases) go through strtof, and other forms (inf, nan,
+ * hexadecimal) through strtod.
+ */
+static bool parseFloat(const char*& p, const char* end, float& value)
+{
+    while (p < end && isBlank(*p))
+        ++p;
+
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+    bool hexadecimal = (p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'));
+
+    // Mantissa of the first 18 digits, and are the next ones all zeros ?
+    const char* digitsBegin = p;
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool digits = false;
+    bool truncated = false;
+    for (; p < end && isDigit(*p); ++p, digits = true)
+    {
+        if (mantissa < 100000000000000000ull)
+            mantissa = 10 * mantissa + (*p - '0');
+        else
+        {
+            ++exponent;
+            truncated |= (*p != '0');
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && isDigit(*p); ++p, digits = true)
+        {
+            if (mantissa < 100000000000000000ull)
+            {
+                mantissa = 10 * mantissa + (*p - '0');
+                --exponent;
+            }
+            else
+                truncated |= (*p != '0');
+        }
+    }
+    const char* digitsEnd = p;
+
+    if (!digits || hexadecimal)
+    {
+        // Copy the token, as strtod needs a null terminated string
+        char token[64];
+        size_t length = 0;
+        for (p = start; p < end && !isBlank(*p) && length + 1 < sizeof(token); ++p)
+            token[length++] = *p;
+        token[length] = '\0';
+
+        char* parsed = nullptr;
+        value = (float)std::strtod(token, &parsed);
+        p = start + (parsed - token);
+        return parsed != token;
+    }
+
+    int power = 0;
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* e = p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExponent = (*p++ == '-');
+
+        if (p < end && isDigit(*p))
+        {
+            for (; p < end && isDigit(*p); ++p)
+                power = std::min(10 * power + (*p - '0'), 100000);
+            if (negativeExponent)
+                power = -power;
+            exponent += power;
+        }
+        else
+            p = e; // Not an exponent
+    }
+
+    if (!truncated && mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10)
+    {
+        float number = (float)mantissa;
+        if (exponent >= 0)
+            number *= (float)POWERS_OF_TEN[exponent];
+        else
+            number /= (float)POWERS_OF_TEN[-exponent];
+
+        value = negative ? -number : number;
+        return true;
+    }
+
+    if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+    {
+        double number = (double)mantissa;
+        if (exponent >= 0)
+            number *= POWERS_OF_TEN[exponent];
+        else
+            number /= POWERS_OF_TEN[-exponent];
+
+        float rounded = (float)number;
+        if (!isFloatMidpoint(number, rounded))
+        {
+            value = negative ? -rounded : rounded;
+            return true;
+        }
+    }
+
+    float number = parseDigits(digitsBegin, digitsEnd, power);
+    value = negative ? -number : number;
+    return true;
+}
+
+namespace
+{
+    /**
+     * Lines of a text file, parsed by a thread of readText
+     */
+    struct TextChunk
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        std::vector<glm::vec3> points;
+        std::vector<size_t> malformedLines; // Line numbers from the start of the chunk
+        size_t lineCount = 0;
+    };
+}
+
+static void parseChunk(TextChunk& chunk)
+{
+    chunk.points.reserve((chunk.end - chunk.begin) / 24);
+    chunk.lineCount = 0;
+
+    for (const char* line = chunk.begin; line < chunk.end; ++chunk.lineCount)
+    {
+        const void* lineFeed = std::memchr(line, '\n', chunk.end - line);
+        const char* lineEnd = lineFeed ? static_cast<const char*>(lineFeed) : chunk.end;
+
+        const char* p = line;
+        while (p < lineEnd && isBlank(*p))
+            ++p;
+
+        // Blank lines are skipped, and further columns ignored
+        if (p < lineEnd)
+        {
+            glm::vec3 point;
+            if (parseFloat(p, lineEnd, point.x) && parseFloat(p, lineEnd, point.y) && parseFloat(p, lineEnd, point.z) &&
+                (p == lineEnd || isBlank(*p)))
+                chunk.points.push_back(point);
+            else
+                chunk.malformedLines.push_back(chunk.lineCount);
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+
+const uint32_t StrokeFile::VERSION;
+
+
+StrokeFile::StrokeFile()
+    : m_strokes(nullptr)
+    , m_strokeCount(0)
+{}
+
+
+bool StrokeFile::open(const std::string& fileName)
+{
+    close();
+    if (!m_file.open(fileName))
+        return false;
+
+    FileHeader header;
+    if (m_file.size() < sizeof(header))
+    {
+        Logger::Error("StrokeFile : truncated file " + fileName);
+        close();
+        return false;
+    }
+
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+    {
+        Logger::Error("StrokeFile : " + fileName + " is not a stroke file, or its version is not supported");
+        close();
+        return false;
+    }
+
+    // The table and every payload must lie within the file. Sizes are compared by division, so
+    // that crafted counts and offsets cannot wrap around
+    uint64_t fileSize = m_file.size();
+    if (header.strokeCount > (fileSize - sizeof(header)) / sizeof(StrokeEntry))
+    {
+        Logger::Error("StrokeFile : truncated stroke table in " + fileName);
+        close();
+        return false;
+    }
+
+    uint64_t tableEnd = sizeof(header) + (uint64_t)header.strokeCount * sizeof(StrokeEntry);
+    const StrokeEntry* strokes = reinterpret_cast<const StrokeEntry*>(m_file.data() + sizeof(header));
+    for (size_t i = 0; i < header.strokeCount; ++i)
+    {
+        uint64_t vectors = (strokes[i].flags & HAS_TANGENTS) ? 2 : 1;
+        uint64_t offset = strokes[i].offset;
+        if (strokes[i].count == 0 || offset % alignof(glm::vec3) != 0 || offset < tableEnd || offset > fileSize ||
+            strokes[i].count > (fileSize - offset) / (vectors * sizeof(glm::vec3)))
+        {
+            std::stringstream ss;
+            ss << "StrokeFile : invalid stroke " << i << " in " << fileName;
+            Logger::Error(ss.str());
+            close();
+            return false;
+        }
+    }
+
+    m_strokes = strokes;
+    m_strokeCount = header.strokeCount;
+    return true;
+}
+
+void StrokeFile::close()
+{
+    m_file.close();
+    m_strokes = nullptr;
+    m_strokeCount = 0;
+}
+
+
+StrokeFile::StrokeView StrokeFile::getStroke(size_t i) const
+{
+    const StrokeEntry& stroke = m_strokes[i];
+    const glm::vec3* points = reinterpret_cast<const glm::vec3*>(m_file.data() + stroke.offset);
+
+    StrokeView view;
+    view.points = points;
+    view.tangents = (stroke.flags & HAS_TANGENTS) ? points + stroke.count : nullptr;
+    view.count = stroke.count;
+    return view;
+}
+
+CurvePtr StrokeFile::createCurve(size_t i) const
+{
+    StrokeView stroke = getStroke(i);
+    std::vector<glm::vec3> points(stroke.points, stroke.points + stroke.count);
+
+    if (stroke.tangents)
+        return std::make_shared<HermiteSpline>(points, std::vector<glm::vec3>(stroke.tangents, stroke.tangents + stroke.count));
+
+    return std::make_shared<LinearSpline>(points);
+}
+
+
+bool StrokeFile::write(const std::string& fileName, const std::vector<Stroke>& strokes)
+{
+    // Counts are stored on 32 bits, and open rejects empty strokes: such input is rejected before
+    // creating the file, rather than written as a file that reads back wrong or not at all
+    const size_t MAX_COUNT = std::numeric_limits<uint32_t>::max();
+    if (strokes.size() > MAX_COUNT)
+    {
+        Logger::Error("StrokeFile : too many strokes to write " + fileName);
+        return false;
+    }
+
+    for (size_t i = 0; i < strokes.size(); ++i)
+    {
+        const Stroke& stroke = strokes[i];
+        if (stroke.points.empty() || stroke.points.size() > MAX_COUNT ||
+            (!stroke.tangents.empty() && stroke.tangents.size() != stroke.points.size()))
+        {
+            std::stringstream ss;
+            ss << "StrokeFile : cannot write stroke " << i << " (" << stroke.points.size() << " points, "
+               << stroke.tangents.size() << " tangents) to " << fileName;
+            Logger::Error(ss.str());
+            return false;
+        }
+    }
+
+    std::ofstream stream(fileName, std::ios::binary);
+    if (!stream.is_open())
+    {
+        Logger::Error("StrokeFile : failed to create file " + fileName);
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.strokeCount = (uint32_t)strokes.size();
+    header.reserved = 0;
+
+    // Payload offsets, each one aligned
+    std::vector<StrokeEntry> table(strokes.size());
+    uint64_t offset = sizeof(header) + strokes.size() * sizeof(StrokeEntry);
+    for (size_t i = 0; i < strokes.size(); ++i)
+    {
+        bool tangents = !strokes[i].tangents.empty();
+        offset = (offset + PAYLOAD_ALIGNMENT - 1) / PAYLOAD_ALIGNMENT * PAYLOAD_ALIGNMENT;
+        table[i].offset = offset;
+        table[i].count = (uint32_t)strokes[i].points.size();
+        table[i].flags = tangents ? HAS_TANGENTS : 0;
+
+        offset += (tangents ? 2 : 1) * strokes[i].points.size() * sizeof(glm::vec3);
+    }
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(StrokeEntry));
+
+    const char padding[PAYLOAD_ALIGNMENT] = {};
+    for (size_t i = 0; i < strokes.size(); ++i)
+    {
+        stream.write(padding, table[i].offset - (uint64_t)stream.tellp());
+        stream.write(reinterpret_cast<const char*>(strokes[i].points.data()), strokes[i].points.size() * sizeof(glm::vec3));
+        stream.write(reinterpret_cast<const char*>(strokes[i].tangents.data()), strokes[i].tangents.size() * sizeof(glm::vec3));
+    }
+
+    if (!stream)
+    {
+        Logger::Error("StrokeFile : failed to write file " + fileName);
+        return false;
+    }
+
+    return true;
+}
+
+bool StrokeFile::write(const std::string& fileName, const std::vector<CurvePtr>& curves)
+{
+    std::vector<Stroke> strokes(curves.size());
+    for (size_t i = 0; i < curves.size(); ++i)
+    {
+        strokes[i].points = curves[i]->getControlPoints();
+        if (curves[i]->kind() == CurveKind::HERMITE)
+            strokes[i].tangents = static_cast<const HermiteSpline&>(*curves[i]).get_tangents();
+    }
+
+    return write(fileName, strokes);
+}
+
+
+bool StrokeFile::readText(const std::string& fileName, std::vector<glm::vec3>& points,
+                          std::vector<size_t>* malformedLines)
+{
+    MappedFile file;
+    if (!file.open(fileName))
+        return false;
+
+    // Chunks end after a line feed, so that lines are never split
+    const char* data = file.data();
+    std::vector<TextChunk> chunks;
+    for (size_t begin = 0; begin < file.size();)
+    {
+        size_t end = std::min(begin + TEXT_CHUNK_SIZE, file.size());
+        if (end < file.size())
+        {
+            const void* lineFeed = std::memchr(data + end, '\n', file.size() - end);
+            end = lineFeed ? static_cast<const char*>(lineFeed) - data + 1 : file.size();
+        }
+
+        TextChunk chunk;
+        chunk.begin = data + begin;
+        chunk.end = data + end;
+        chunks.push_back(chunk);
+
+        begin = end;
+    }
+
+    ThreadPool& pool = ThreadPool::Get();
+    pool.parallelFor(chunks.size(), 1, [&chunks](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            parseChunk(chunks[i]);
+    });
+
+    // Merge in order: offsets of the points and first line of each chunk
+    std::vector<size_t> offsets(chunks.size() + 1, 0);
+    std::vector<size_t> firstLines(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        offsets[i + 1] = offsets[i] + chunks[i].points.size();
+        firstLines[i + 1] = firstLines[i] + chunks[i].lineCount;
+    }
+
+    points.resize(offsets.back());
+    pool.parallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            std::copy(chunks[i].points.begin(), chunks[i].points.end(), points.begin() + offsets[i]);
+    });
+
+    size_t malformedCount = 0;
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        for (size_t line : chunks[i].malformedLines)
+        {
+            size_t number = firstLines[i] + line + 1;
+            if (malformedLines)
+                malformedLines->push_back(number);
+
+            if (malformedCount++ < MAX_LOGGED_LINES)
+            {
+                std::stringstream ss;
+                ss << "StrokeFile : malformed line " << number << " in " << fileName;
+                Logger::Warning(ss.str());
+            }
+        }
+    }
+
+    if (malformedCount > MAX_LOGGED_LINES)
+    {
+        std::stringstream ss;
+        ss << "StrokeFile : " << malformedCount << " malformed lines in " << fileName;
+        Logger::Warning(ss.str());
+    }
+
+    return true;
+}
+
+bool StrokeFile::convertText(const std::vector<std::string>& textFiles, const std::string& fileName)
+{
+    std::vector<Stroke> strokes(textFiles.size());
+    for (size_t i = 0; i < textFiles.size(); ++i)
+    {
+        if (!readText(textFiles[i], strokes[i].points))
+            return false;
+
+        if (strokes[i].points.empty())
+        {
+            Logger::Error("StrokeFile : no point in " + textFiles[i]);
+            return false;
+        }
+    }
+
+    return write(fileName, strokes);
+}
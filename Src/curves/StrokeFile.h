@@ -0,0 +1,97 @@
+#ifndef __STROKEFILE_H__
+#define __STROKEFILE_H__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "curves/Curve.h"
+#include "utils/MappedFile.h"
+
+
+/**
+ * Binary container of strokes, read through a memory mapping: strokes are used in place,
+ * without parsing nor copying.
+ * Layout (little endian, 32-bit floats):
+ * - header: magic "STRK", version, number of strokes, reserved
+ * - stroke table: for each stroke, offset of its payload from the start of the file (64 bits),
+ *   number of points and flags (HAS_TANGENTS)
+ * - payloads, aligned on 16 bytes: x, y, z of each point, followed by the tangents if any
+ */
+class StrokeFile
+{
+public:
+    static const uint32_t VERSION = 1;
+
+    struct Stroke
+    {
+        std::vector<glm::vec3> points;
+        std::vector<glm::vec3> tangents; // Empty for polylines
+    };
+
+    /**
+     * Stroke of the mapped file, valid until the file is closed
+     */
+    struct StrokeView
+    {
+        const glm::vec3* points;
+        const glm::vec3* tangents; // nullptr for polylines
+        size_t count;
+    };
+
+    StrokeFile();
+
+    StrokeFile(const StrokeFile&) = delete;
+    StrokeFile& operator=(const StrokeFile&) = delete;
+
+    bool open(const std::string& fileName);
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+
+    size_t getStrokeCount() const { return m_strokeCount; }
+    StrokeView getStroke(size_t i) const;
+
+    /**
+     * Curve of a stroke: a HermiteSpline with the stored tangents, or a LinearSpline
+     */
+    CurvePtr createCurve(size_t i) const;
+
+    /**
+     * Writes strokes. Curves are written as polylines of their control points, with the tangents
+     * of HermiteSplines.
+     * Fails without creating the file if a stroke is empty, has tangents that do not match its
+     * points, or if a count does not fit the 32 bits of the format.
+     */
+    static bool write(const std::string& fileName, const std::vector<Stroke>& strokes);
+    static bool write(const std::string& fileName, const std::vector<CurvePtr>& curves);
+
+    /**
+     * Text stroke files: one "x y z" point per line (blank lines and further columns are ignored).
+     * The file is mapped, and parsed by chunks in parallel (see ThreadPool).
+     * Malformed lines are skipped and logged, and their numbers (starting at 1) are returned
+     * in malformedLines if given.
+     */
+    static bool readText(const std::string& fileName, std::vector<glm::vec3>& points,
+                         std::vector<size_t>* malformedLines = nullptr);
+    static bool convertText(const std::vector<std::string>& textFiles, const std::string& fileName);
+
+private:
+    struct StrokeEntry
+    {
+        uint64_t offset;
+        uint32_t count;
+        uint32_t flags;
+    };
+
+    MappedFile m_file;
+    const StrokeEntry* m_strokes;
+    size_t m_strokeCount;
+};
+
+using StrokeFilePtr = std::shared_ptr<StrokeFile>;
+
+#endif // __STROKEFILE_H__
@@ -2,6 +2,7 @@
 
 #include <iostream>
 
+#include "curves/CurveDispatch.h"
 #include "viewer/Viewer.h"
 
 
@@ -27,8 +28,18 @@ CoonsPatch::CoonsPatch(const CurvePtr& C0, const CurvePtr& C1, const CurvePtr& D
 }
 
 
+// Evaluates the curve at all the params through its concrete type: the type is resolved once for
+// the batch, then the batch kernel of HermiteSpline or LinearSpline is called directly
+static void sampleCurve(const Curve& C, const std::vector<float>& params, std::vector<glm::vec3>& points)
+{
+    points.resize(params.size());
+    dispatch_curve(C, [&](const auto& curve) { curve.get_points(params.data(), params.size(), points.data()); });
+}
+
+
 glm::vec3 CoonsPatch::evaluate(float u, float v)
 {
+    // A single point cannot amortize a dispatch on the curve types: grids go through evaluateGrid
     glm::vec3 Lc = glm::mix(m_C0->get_point(u), m_C1->get_point(u), v);
     glm::vec3 Ld = glm::mix(m_D0->get_point(v), m_D1->get_point(v), u);
 
@@ -41,6 +52,51 @@ glm::vec3 CoonsPatch::evaluate(float u, float v)
     return Lc + Ld - B;
 }
 
+void CoonsPatch::evaluateGrid(const std::vector<float>& us, const std::vector<float>& vs, std::vector<glm::vec3>& points)
+{
+    // Boundary curves are sampled once for the whole grid
+    std::vector<glm::vec3> C0, C1, D0, D1;
+    sampleCurve(*m_C0, us, C0);
+    sampleCurve(*m_C1, us, C1);
+    sampleCurve(*m_D0, vs, D0);
+    sampleCurve(*m_D1, vs, D1);
+
+    glm::vec3 C00 = m_C0->get_point(0.0f);
+    glm::vec3 C01 = m_C0->get_point(1.0f);
+    glm::vec3 C10 = m_C1->get_point(0.0f);
+    glm::vec3 C11 = m_C1->get_point(1.0f);
+
+    points.resize(us.size() * vs.size());
+    for (size_t v = 0; v < vs.size(); ++v)
+    {
+        for (size_t u = 0; u < us.size(); ++u)
+        {
+            glm::vec3 Lc = glm::mix(C0[u], C1[u], vs[v]);
+            glm::vec3 Ld = glm::mix(D0[v], D1[v], us[u]);
+            glm::vec3 B  = glm::mix(glm::mix(C00, C01, us[u]), glm::mix(C10, C11, us[u]), vs[v]);
+
+            points[v * us.size() + u] = Lc + Ld - B;
+        }
+    }
+}
+
+AABB CoonsPatch::getBounds()
+{
+    // Lc and Ld are convex combinations of points of opposite boundaries, B of the corners
+    AABB Lc = m_C0->get_bounds();
+    Lc.extend(m_C1->get_bounds());
+    AABB Ld = m_D0->get_bounds();
+    Ld.extend(m_D1->get_bounds());
+
+    AABB B;
+    B.extend(m_C0->get_point(0.0f));
+    B.extend(m_C0->get_point(1.0f));
+    B.extend(m_C1->get_point(0.0f));
+    B.extend(m_C1->get_point(1.0f));
+
+    return AABB(Lc.min + Ld.min - B.max, Lc.max + Ld.max - B.min);
+}
+
 void CoonsPatch::draw()
 {
     ShaderProgram& pointProgram = *(Viewer::Get().getProgram("point"));
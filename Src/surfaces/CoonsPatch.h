@@ -15,6 +15,13 @@ public:
     void setColor(const glm::vec4& color) { m_color = color; }
 
     glm::vec3 evaluate(float u, float v) override;
+    void evaluateGrid(const std::vector<float>& us, const std::vector<float>& vs, std::vector<glm::vec3>& points) override;
+
+    /**
+     * Sum of the boxes of the three terms of the patch, computed from the cached bounds of the
+     * boundary curves: it contains the patch, but can be larger.
+     */
+    AABB getBounds() override;
 
     void draw() override;
 
@@ -1,19 +1,21 @@
 #include "DynamicSurface.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
-#include <glm/gtx/quaternion.hpp>
-#include <glm/gtx/rotate_vector.hpp>
-
 #include "curves/HermiteSpline.h"
 #include "curves/LinearSpline.h"
+#include "utils/FastMath.h"
 #include "utils/Logger.h"
+#include "utils/ThreadPool.h"
 
 
 #define RAD_DEG(rad) rad * 180.0f / 3.141592f
 #define DEG_RAD(deg) deg * 3.141592f / 180.0f
 
+static const float PI = 3.14159265f;
+
 
 static const glm::vec3 X_AXIS(1.0f, 0.0f, 0.0f);
 static const glm::vec3 Z_AXIS(0.0f, 0.0f, 1.0f);
@@ -29,119 +31,448 @@ static float computeAngle(const glm::vec3& source, const glm::vec3& target)
     return angle;
 }
 
-static float computeAngle(const CurvePtr& C, float s, float ds)
+static float computeAngle(const std::vector<glm::vec3>& samples, size_t i)
 {
-    glm::vec3 vec = C->get_point(s + ds) - C->get_point(s);
-    return computeAngle(X_AXIS, glm::normalize(vec));
+    // No normalization: the angle does not depend on the length, and is null for coincident samples
+    glm::vec3 vec = samples[i + 1] - samples[i];
+    return computeAngle(X_AXIS, vec);
 }
 
-static float computeLength(
-    const CurvePtr& C,
-    const CurvePtr& prevC,
-    const CurvePtr& nextC,
-    float s,
-    float ds,
-    bool derivative
-)
+static float computeLength(const std::vector<glm::vec3>& samples, size_t i)
 {
-    if (derivative)
-    {
-        if (prevC && nextC)
-        {
-            float prevL = glm::length(prevC->get_point(s + ds) - prevC->get_point(s));
-            float nextL = glm::length(nextC->get_point(s + ds) - nextC->get_point(s));
-            return 0.5f * (nextL - prevL);
-        }
-        else
-            return 0.0f;
-    }
-    else
-        return glm::length(C->get_point(s + ds) - C->get_point(s));
+    return glm::length(samples[i + 1] - samples[i]);
 }
 
+/**
+ * Difference of the angles A1 - A0, wrapped to [-pi, pi] (shortest arc)
+ */
+static float angleDelta(float A0, float A1)
+{
+    float D = A1 - A0;
+    if (D > PI)
+        D -= 2.0f * PI;
+    else if (D < -PI)
+        D += 2.0f * PI;
+    return D;
+}
+
+/**
+ * Samples the curve at s = i / sampling, i in [0, sampling]. Returns no sample if there is no curve.
+ */
+static std::vector<glm::vec3> sampleCurve(const CurvePtr& C, size_t sampling)
+{
+    if (!C)
+        return std::vector<glm::vec3>();
+
+    return C->resample_uniform(sampling + 1);
+}
+
+
+CurvePtr StrokeSweep::createCurve(size_t i) const
+{
+    if (keyStrokes[i])
+        return keyStrokes[i];
+
+    const glm::vec3* stroke = getStroke(i);
+    return std::make_shared<LinearSpline>(std::vector<glm::vec3>(stroke, stroke + strokeSize));
+}
+
+
+const size_t DynamicSurface::TIME_BATCH;
+const size_t DynamicSurface::SCAN_GRAIN_SIZE;
+const size_t DynamicSurface::DEFAULT_CACHE_BYTES;
+const size_t DynamicSurface::DEFAULT_PARALLEL_SCAN_MIN_SAMPLING;
 
 DynamicSurface::DynamicSurface(size_t sampling)
-    : m_sampling { sampling }
+    : m_sampling { sampling },
+      m_parallelScanMinSampling { DEFAULT_PARALLEL_SCAN_MIN_SAMPLING },
+      m_cacheResolution { 0.0f },
+      m_cacheMaxBytes { DEFAULT_CACHE_BYTES },
+      m_cacheHits { 0 },
+      m_cacheMisses { 0 }
 {}
 
+void DynamicSurface::addKeyStroke(float t, const CurvePtr& keyStroke)
+{
+    auto inserted = m_keyStrokes.insert({ t, KeyStroke() });
+    if (!inserted.second)
+        return;
+
+    KeyStrokeMap::iterator it = inserted.first;
+    it->second.curve = keyStroke;
+    computeProfiles(it->second);
+    invalidateCache(it);
+
+    // The tangents of the neighbours depend on the new key stroke
+    computeTangents(it);
+    if (it != m_keyStrokes.begin())
+        computeTangents(std::prev(it));
+    if (std::next(it) != m_keyStrokes.end())
+        computeTangents(std::next(it));
+}
+
+void DynamicSurface::setSampling(size_t sampling)
+{
+    m_sampling = sampling;
+    clearCache();
+
+    for (auto& keyStroke : m_keyStrokes)
+        computeProfiles(keyStroke.second);
+    for (auto it = m_keyStrokes.begin(); it != m_keyStrokes.end(); ++it)
+        computeTangents(it);
+}
+
 CurvePtr DynamicSurface::interpolate(float t)
 {
+    // Times outside of the key strokes are invalid, whether the cache is enabled or not
+    if (m_keyStrokes.empty() || !(t >= m_keyStrokes.begin()->first && t <= m_keyStrokes.rbegin()->first))
+    {
+        Logger::Error("DynamicSurface::interpolate : invalid time " + std::to_string(t));
+        return nullptr;
+    }
+
+    // Rounded time, kept within the key strokes (the first and last ones are returned as is)
+    long long cacheKey = 0;
+    if (m_cacheResolution > 0.0f)
+    {
+        cacheKey = std::llround(t / m_cacheResolution);
+        t = glm::clamp(cacheKey * m_cacheResolution, m_keyStrokes.begin()->first, m_keyStrokes.rbegin()->first);
+    }
+
     // Do we ask for a key stroke ?
     auto it = m_keyStrokes.find(t);
     if (it != m_keyStrokes.end())
-        return it->second;
+        return it->second.curve;
 
     // Get key strokes surrounding the given time
-    auto itlow = std::prev(m_keyStrokes.lower_bound(t));
     auto itup = m_keyStrokes.upper_bound(t);
-    if (itlow == m_keyStrokes.end() || itup == m_keyStrokes.end())
+    auto itlow = std::prev(itup);
+
+    // The tangents of both key strokes also depend on their other neighbours
+    if (itlow != m_keyStrokes.begin())
+        refresh(std::prev(itlow));
+    refresh(itlow);
+    refresh(itup);
+    if (std::next(itup) != m_keyStrokes.end())
+        refresh(std::next(itup));
+
+    if (m_cacheResolution > 0.0f)
     {
-        Logger::Error("DynamicSurface::interpolate : invalid time " + std::to_string(t));
-        return nullptr;
+        auto cached = m_cache.find(cacheKey);
+        if (cached != m_cache.end())
+        {
+            ++m_cacheHits;
+            m_cacheOrder.splice(m_cacheOrder.begin(), m_cacheOrder, cached->second.order);
+            return std::make_shared<LinearSpline>(*cached->second.stroke);
+        }
+        ++m_cacheMisses;
     }
 
-    CurvePtr& C0 = itlow->second;
-    CurvePtr& C1 = itup->second;
+    float normalizedT = (t - itlow->first) / (itup->first - itlow->first);
 
-    // Get key strokes just before and after key strokes (to compute derivatives)
-    CurvePtr& prevC0 = (std::prev(itlow) != m_keyStrokes.end()) ? std::prev(itlow)->second : nullptr;
-    CurvePtr& nextC1 = (std::next(itup) != m_keyStrokes.end()) ? std::next(itup)->second : nullptr;
+    std::vector<glm::vec3> samples(m_sampling + 1);
+    if (m_sampling >= m_parallelScanMinSampling)
+        interpolateScan(itlow->second, itup->second, normalizedT, samples.data());
+    else
+        interpolate(itlow->second, itup->second, &normalizedT, 1, samples.data());
+    auto stroke = std::make_shared<LinearSpline>(samples);
 
-    float normalizedT = (t - itlow->first) / (itup->first - itlow->first);
-    return interpolate(C0, C1, prevC0, nextC1, normalizedT);
+    // The cache keeps its own copy
+    if (m_cacheResolution > 0.0f)
+    {
+        size_t capacity = getCacheCapacity();
+        while (m_cache.size() >= capacity)
+        {
+            m_cache.erase(m_cacheOrder.back());
+            m_cacheOrder.pop_back();
+        }
+
+        m_cacheOrder.push_front(cacheKey);
+        m_cache[cacheKey] = CacheEntry { std::make_shared<const LinearSpline>(*stroke), m_cacheOrder.begin() };
+    }
+
+    return stroke;
 }
 
+StrokeSweep DynamicSurface::interpolate(const float* times, size_t count)
+{
+    StrokeSweep sweep;
+    sweep.strokeSize = m_sampling + 1;
+    if (m_keyStrokes.empty())
+    {
+        Logger::Error("DynamicSurface::interpolate : no key stroke");
+        return sweep;
+    }
+
+    sweep.times.assign(times, times + count);
+    sweep.points.resize(count * sweep.strokeSize);
+    sweep.keyStrokes.resize(count);
+
+    // The profiles must be up to date before the threads read them
+    for (auto it = m_keyStrokes.begin(); it != m_keyStrokes.end(); ++it)
+        refresh(it);
+
+    float first = m_keyStrokes.begin()->first;
+    float last = m_keyStrokes.rbegin()->first;
+    if (std::any_of(times, times + count, [=](float t) { return t < first || t > last; }))
+        Logger::Warning("DynamicSurface::interpolate : times clamped to [" + std::to_string(first) + ", " +
+                        std::to_string(last) + "]");
+
+    // Consecutive times between the same key strokes are interpolated together
+    ThreadPool::Get().parallelFor(count, TIME_BATCH, [&](size_t begin, size_t end)
+    {
+        float ts[TIME_BATCH];
+        size_t i = begin;
+        while (i < end)
+        {
+            float t = glm::clamp(times[i], first, last);
+            glm::vec3* points = &sweep.points[i * sweep.strokeSize];
+
+            auto itup = m_keyStrokes.upper_bound(t);
+            auto itlow = std::prev(itup);
+            if (itup == m_keyStrokes.end() || itlow->first == t)
+            {
+                std::vector<glm::vec3> samples = sampleCurve(itlow->second.curve, m_sampling);
+                std::copy(samples.begin(), samples.end(), points);
+                sweep.keyStrokes[i] = itlow->second.curve;
+                ++i;
+                continue;
+            }
+
+            size_t n = 0;
+            for (; i < end && n < TIME_BATCH; ++i, ++n)
+            {
+                t = glm::clamp(times[i], first, last);
+                if (t <= itlow->first || t >= itup->first)
+                    break;
+                ts[n] = (t - itlow->first) / (itup->first - itlow->first);
+            }
+            interpolate(itlow->second, itup->second, ts, n, points);
+        }
+    });
+
+    return sweep;
+}
 
-CurvePtr DynamicSurface::interpolate(
-    const CurvePtr& C0,
-    const CurvePtr& C1,
-    const CurvePtr& prevC0,
-    const CurvePtr& nextC1,
-    float t
-)
+void DynamicSurface::setCache(float resolution, size_t maxBytes)
 {
-    std::vector<glm::vec3> samples;
-    samples.reserve(m_sampling + 1);
+    if (resolution < 0.0f)
+    {
+        Logger::Warning("DynamicSurface::setCache : negative resolution, cache disabled");
+        resolution = 0.0f;
+    }
 
-    glm::vec3 prevPoint(0.0f);
-    samples.push_back(prevPoint);
+    m_cacheResolution = resolution;
+    m_cacheMaxBytes = maxBytes;
+    m_cacheHits = 0;
+    m_cacheMisses = 0;
+    clearCache();
+}
+
+void DynamicSurface::clearCache()
+{
+    m_cache.clear();
+    m_cacheOrder.clear();
+}
+
+StrokeSweep DynamicSurface::interpolateRange(float t0, float t1, size_t n)
+{
+    std::vector<float> times(n);
+    for (size_t i = 0; i < n; ++i)
+        times[i] = (n > 1) ? t0 + (t1 - t0) * i / (n - 1) : t0;
+
+    return interpolate(times);
+}
+
+
+void DynamicSurface::computeProfiles(KeyStroke& keyStroke)
+{
+    std::vector<glm::vec3> samples = sampleCurve(keyStroke.curve, m_sampling);
+
+    keyStroke.revision = keyStroke.curve->get_revision();
+    keyStroke.angles.resize(m_sampling);
+    keyStroke.lengths.resize(m_sampling);
+    keyStroke.root = samples.front();
 
-    // Iteratively compute points (angle-length representation)
-    float ds = 1.0f / m_sampling;
     for (size_t i = 0; i < m_sampling; ++i)
     {
-        float s = i * ds;
-
-        // Angle
-        float A0 = computeAngle(C0, s, ds);
-        float A1 = computeAngle(C1, s, ds);
-
-        glm::quat Q0 = glm::angleAxis(A0, Z_AXIS);
-        glm::quat Q1 = glm::angleAxis(A1, Z_AXIS);
-        glm::quat Q  = glm::slerp(Q0, Q1, t);
-
-        // Length
-        float L0  = computeLength(C0, nullptr, nullptr, s, ds, false);
-        float L1  = computeLength(C1, nullptr, nullptr, s, ds, false);
-        float DL0 = computeLength(nullptr, prevC0, C1, s, ds, true);
-        float DL1 = computeLength(nullptr, C0, nextC1, s, ds, true);
-        float L   = Hermite<float>(L0, L1, DL0, DL1, t);
-
-        // Compute new point
-        prevPoint += L * glm::rotate(Q, X_AXIS);
-        samples.push_back(prevPoint);
+        keyStroke.angles[i] = computeAngle(samples, i);
+        keyStroke.lengths[i] = computeLength(samples, i);
     }
+}
+
+void DynamicSurface::computeTangents(KeyStrokeMap::iterator it)
+{
+    KeyStroke& keyStroke = it->second;
+    keyStroke.lengthTangents.assign(m_sampling, 0.0f);
+    keyStroke.rootTangent = glm::vec3(0.0f);
 
-    // Interpolate roots
-    float rootS = 0.0f;
-    glm::vec3 R0 = C0->get_point(rootS);
-    glm::vec3 R1 = C1->get_point(rootS);
-    glm::vec3 T0 = prevC0 ? 0.5f * (C1->get_point(rootS) - prevC0->get_point(rootS)) : glm::vec3(0.0f);
-    glm::vec3 T1 = nextC1 ? 0.5f * (nextC1->get_point(rootS) - C0->get_point(rootS)) : glm::vec3(0.0f);
-    glm::vec3 R  = Hermite<glm::vec3>(R0, R1, T0, T1, t);
+    if (it == m_keyStrokes.begin() || std::next(it) == m_keyStrokes.end())
+        return;
 
-    for (glm::vec3& V : samples)
-        V += R;
+    const KeyStroke& prev = std::prev(it)->second;
+    const KeyStroke& next = std::next(it)->second;
+    for (size_t i = 0; i < m_sampling; ++i)
+        keyStroke.lengthTangents[i] = 0.5f * (next.lengths[i] - prev.lengths[i]);
+    keyStroke.rootTangent = 0.5f * (next.root - prev.root);
+}
+
+void DynamicSurface::refresh(KeyStrokeMap::iterator it)
+{
+    if (it->second.curve->get_revision() == it->second.revision)
+        return;
+
+    computeProfiles(it->second);
+    invalidateCache(it);
+
+    computeTangents(it);
+    if (it != m_keyStrokes.begin())
+        computeTangents(std::prev(it));
+    if (std::next(it) != m_keyStrokes.end())
+        computeTangents(std::next(it));
+}
+
+void DynamicSurface::invalidateCache(KeyStrokeMap::iterator it)
+{
+    if (m_cache.empty())
+        return;
+
+    // Interpolations between the neighbours of it use its profiles, and those between their
+    // own neighbours use the tangents of the neighbours. Rounded times on the bounds are also
+    // dropped, in case of rounding errors.
+    auto first = m_cache.begin();
+    auto last = m_cache.end();
+    auto itlow = it;
+    for (int i = 0; i < 2 && itlow != m_keyStrokes.begin(); ++i)
+        --itlow;
+    if (itlow != it)
+        first = m_cache.lower_bound((long long)std::floor(itlow->first / m_cacheResolution));
+
+    auto itup = it;
+    for (int i = 0; i < 2 && std::next(itup) != m_keyStrokes.end(); ++i)
+        ++itup;
+    if (itup != it)
+        last = m_cache.upper_bound((long long)std::ceil(itup->first / m_cacheResolution));
+
+    for (auto entry = first; entry != last; ++entry)
+        m_cacheOrder.erase(entry->second.order);
+    m_cache.erase(first, last);
+}
+
+size_t DynamicSurface::getCacheCapacity() const
+{
+    size_t strokeBytes = sizeof(LinearSpline) + (m_sampling + 1) * (sizeof(glm::vec3) + 2 * sizeof(float));
+    return std::max<size_t>(m_cacheMaxBytes / strokeBytes, 1);
+}
 
-    return std::make_shared<LinearSpline>(samples);
+void DynamicSurface::interpolate(const KeyStroke& K0, const KeyStroke& K1, const float* ts, size_t count,
+                                 glm::vec3* points) const
+{
+    typedef HermiteBasis<float> Basis;
+    const size_t strokeSize = m_sampling + 1;
+
+    float t[TIME_BATCH], h0[TIME_BATCH], h1[TIME_BATCH], h2[TIME_BATCH], h3[TIME_BATCH];
+    float x[TIME_BATCH], y[TIME_BATCH];
+
+    for (size_t first = 0; first < count; first += TIME_BATCH)
+    {
+        size_t n = std::min(count - first, TIME_BATCH);
+        glm::vec3* batch = points + first * strokeSize;
+
+        for (size_t j = 0; j < n; ++j)
+        {
+            t[j] = glm::clamp(ts[first + j], 0.0f, 1.0f);
+            h0[j] = Basis::polynomial(Basis::POINT[0], t[j]);
+            h1[j] = Basis::polynomial(Basis::POINT[1], t[j]);
+            h2[j] = Basis::polynomial(Basis::POINT[2], t[j]);
+            h3[j] = Basis::polynomial(Basis::POINT[3], t[j]);
+            x[j] = 0.0f;
+            y[j] = 0.0f;
+        }
+
+        // Interpolate roots
+        for (size_t j = 0; j < n; ++j)
+            batch[j * strokeSize] = h0[j] * K0.root + h1[j] * K0.rootTangent + h2[j] * K1.root + h3[j] * K1.rootTangent;
+
+        // Iteratively compute points (angle-length representation). Rotations around the Z axis
+        // are slerped along the shortest arc, which is a linear blend of the wrapped angles.
+        for (size_t i = 0; i < m_sampling; ++i)
+        {
+            float A0 = K0.angles[i];
+            float D = angleDelta(A0, K1.angles[i]);
+
+            float L0 = K0.lengths[i], L1 = K1.lengths[i];
+            float T0 = K0.lengthTangents[i], T1 = K1.lengthTangents[i];
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                float sine, cosine;
+                FastSinCos(A0 + t[j] * D, sine, cosine);
+                float L = h0[j] * L0 + h1[j] * T0 + h2[j] * L1 + h3[j] * T1;
+                x[j] += L * cosine;
+                y[j] += L * sine;
+            }
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                const glm::vec3& R = batch[j * strokeSize];
+                batch[j * strokeSize + i + 1] = glm::vec3(R.x + x[j], R.y + y[j], R.z);
+            }
+        }
+    }
+}
+
+void DynamicSurface::interpolateScan(const KeyStroke& K0, const KeyStroke& K1, float t, glm::vec3* points) const
+{
+    typedef HermiteBasis<float> Basis;
+
+    t = glm::clamp(t, 0.0f, 1.0f);
+    float h0 = Basis::polynomial(Basis::POINT[0], t);
+    float h1 = Basis::polynomial(Basis::POINT[1], t);
+    float h2 = Basis::polynomial(Basis::POINT[2], t);
+    float h3 = Basis::polynomial(Basis::POINT[3], t);
+
+    size_t blockCount = (m_sampling + SCAN_GRAIN_SIZE - 1) / SCAN_GRAIN_SIZE;
+    std::vector<glm::vec2> blockSums(blockCount);
+
+    // Segment vectors, accumulated within each block
+    ThreadPool::Get().parallelFor(blockCount, 1, [&](size_t firstBlock, size_t lastBlock)
+    {
+        for (size_t b = firstBlock; b < lastBlock; ++b)
+        {
+            size_t end = std::min((b + 1) * SCAN_GRAIN_SIZE, m_sampling);
+            float x = 0.0f, y = 0.0f;
+            for (size_t i = b * SCAN_GRAIN_SIZE; i < end; ++i)
+            {
+                float sine, cosine;
+                FastSinCos(K0.angles[i] + t * angleDelta(K0.angles[i], K1.angles[i]), sine, cosine);
+                float L = h0 * K0.lengths[i] + h1 * K0.lengthTangents[i] + h2 * K1.lengths[i] + h3 * K1.lengthTangents[i];
+                x += L * cosine;
+                y += L * sine;
+                points[i + 1] = glm::vec3(x, y, 0.0f);
+            }
+            blockSums[b] = glm::vec2(x, y);
+        }
+    });
+
+    // Root, then offset of each block: root plus the totals of the previous blocks
+    points[0] = h0 * K0.root + h1 * K0.rootTangent + h2 * K1.root + h3 * K1.rootTangent;
+
+    std::vector<glm::vec3> offsets(blockCount);
+    glm::vec3 offset = points[0];
+    for (size_t b = 0; b < blockCount; ++b)
+    {
+        offsets[b] = offset;
+        offset += glm::vec3(blockSums[b], 0.0f);
+    }
+
+    ThreadPool::Get().parallelFor(blockCount, 1, [&](size_t firstBlock, size_t lastBlock)
+    {
+        for (size_t b = firstBlock; b < lastBlock; ++b)
+        {
+            size_t end = std::min((b + 1) * SCAN_GRAIN_SIZE, m_sampling);
+            for (size_t i = b * SCAN_GRAIN_SIZE; i < end; ++i)
+                points[i + 1] += offsets[b];
+        }
+    });
 }
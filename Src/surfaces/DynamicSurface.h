@@ -1,35 +1,188 @@
 #ifndef __DYNAMIC_SURFACE_H__
 #define __DYNAMIC_SURFACE_H__
 
+#include <list>
 #include <map>
+#include <vector>
+
+#include <glm/glm.hpp>
 
 #include "curves/Curve.h"
 
+class LinearSpline;
+
+
+/**
+ * Strokes interpolated at several times, stored contiguously: stroke i is made of the
+ * strokeSize points starting at points[i * strokeSize].
+ */
+struct StrokeSweep
+{
+    std::vector<float> times;
+    std::vector<glm::vec3> points;
+    size_t strokeSize;
+
+    // For each time, the key stroke at this time, or nullptr between key strokes
+    std::vector<CurvePtr> keyStrokes;
+
+    size_t getStrokeCount() const { return times.size(); }
+    const glm::vec3* getStroke(size_t i) const { return points.data() + i * strokeSize; }
+
+    /**
+     * Returns stroke i: the key stroke itself at the time of a key stroke, as
+     * DynamicSurface::interpolate(t), otherwise a LinearSpline of its points
+     */
+    CurvePtr createCurve(size_t i) const;
+};
+
 
 class DynamicSurface
 {
 public:
     DynamicSurface(size_t sampling = 50);
 
-    void addKeyStroke(float t, const CurvePtr& keyStroke) { m_keyStrokes.insert({ t, keyStroke }); }
+    /**
+     * Adds a key stroke at time t, and computes its profiles (see KeyStroke)
+     */
+    void addKeyStroke(float t, const CurvePtr& keyStroke);
 
     size_t getSampling() const { return m_sampling; }
-    void setSampling(size_t sampling) { m_sampling = sampling; }
 
+    /**
+     * Changes the number of segments of the interpolated strokes, and recomputes the profiles
+     */
+    void setSampling(size_t sampling);
+
+    /**
+     * Sampling from which interpolate(t) reconstructs the stroke in parallel. The default,
+     * DEFAULT_PARALLEL_SCAN_MIN_SAMPLING, is two blocks of SCAN_GRAIN_SIZE segments: the smallest
+     * stroke that the scan splits between threads. Tests/InterpolateScanBenchmark.cpp times both
+     * reconstructions.
+     */
+    size_t getParallelScanMinSampling() const { return m_parallelScanMinSampling; }
+    void setParallelScanMinSampling(size_t sampling) { m_parallelScanMinSampling = sampling; }
+
+    /**
+     * Interpolates the key strokes at time t, from their cached profiles. The profiles of key
+     * strokes modified since they were computed (see Curve::get_revision) are recomputed first.
+     * From getParallelScanMinSampling() segments, the stroke is reconstructed in parallel (see
+     * interpolateScan). Its points differ from the serial accumulation by rounding only: summed
+     * by blocks, their error stays below 1e-5 times the length of the stroke up to 1M segments,
+     * where the serial accumulation drifts by about 1e-3.
+     * Times outside of the key strokes are an error: nullptr is returned.
+     * With the cache enabled (see setCache), valid times are rounded to a multiple of its
+     * resolution (kept within the key strokes), and the strokes of the most recently used times
+     * are returned without being recomputed.
+     */
     CurvePtr interpolate(float t);
 
+    /**
+     * Interpolates the key strokes at count times (or n times evenly spaced in [t0, t1]) in
+     * parallel (see ThreadPool), into a sweep of strokes of m_sampling + 1 points in the order
+     * of the times. At the time of a key stroke, the points are samples of the key stroke (see
+     * Curve::resample_uniform), and the key stroke itself is kept in the sweep: createCurve
+     * returns it, like interpolate(t).
+     * Times outside of the key strokes are clamped to the first or last one, with a warning.
+     */
+    StrokeSweep interpolate(const float* times, size_t count);
+    StrokeSweep interpolate(const std::vector<float>& times) { return interpolate(times.data(), times.size()); }
+    StrokeSweep interpolateRange(float t0, float t1, size_t n);
+
+    /**
+     * Enables the cache of interpolate(t), meant for scrubbing: times are rounded to multiples
+     * of resolution, and the strokes of the least recently used ones are dropped when their
+     * total size exceeds maxBytes (estimated from the sampling, at least one stroke is kept).
+     * A null resolution disables the cache. The cache and its counters are cleared.
+     * Cached strokes between two key strokes are dropped when the profiles of either of them or
+     * of their neighbours are recomputed (new key stroke, modified curve, new sampling).
+     * Cached strokes are never handed out: interpolate(t) returns a copy, which callers can
+     * modify without changing later results. Copying the points and params is still much faster
+     * than interpolating them again.
+     */
+    void setCache(float resolution, size_t maxBytes = DEFAULT_CACHE_BYTES);
+    void clearCache();
+
+    size_t getCacheSize() const { return m_cache.size(); }
+    size_t getCacheHits() const { return m_cacheHits; }
+    size_t getCacheMisses() const { return m_cacheMisses; }
+
+    static const size_t DEFAULT_CACHE_BYTES = 64 << 20;
+    static const size_t DEFAULT_PARALLEL_SCAN_MIN_SAMPLING = 8192;
+
 private:
-    std::map<float, CurvePtr> m_keyStrokes;
+    /**
+     * Angle-length representation of a key stroke sampled with m_sampling segments: each
+     * segment is the X axis rotated by its angle around the Z axis, scaled by its length.
+     * The tangents in time of the lengths and of the root are central differences with the
+     * neighbour key strokes, and are null for the first and last ones.
+     */
+    struct KeyStroke
+    {
+        CurvePtr curve;
+        size_t revision;
+
+        std::vector<float> angles;
+        std::vector<float> lengths;
+        glm::vec3 root;
+
+        std::vector<float> lengthTangents;
+        glm::vec3 rootTangent;
+    };
+
+    using KeyStrokeMap = std::map<float, KeyStroke>;
+
+    KeyStrokeMap m_keyStrokes;
 
     size_t m_sampling;
+    size_t m_parallelScanMinSampling;
+
+    /**
+     * Interpolated strokes by rounded time (multiple of m_cacheResolution), with their position
+     * in m_cacheOrder, from the most to the least recently used.
+     */
+    struct CacheEntry
+    {
+        std::shared_ptr<const LinearSpline> stroke;
+        std::list<long long>::iterator order;
+    };
+
+    std::map<long long, CacheEntry> m_cache;
+    std::list<long long> m_cacheOrder;
+    float m_cacheResolution;
+    size_t m_cacheMaxBytes;
+    size_t m_cacheHits;
+    size_t m_cacheMisses;
+
+    /**
+     * Drops the cached strokes which depend on the profiles of the key stroke it, i.e. between
+     * the second key strokes before and after it.
+     */
+    void invalidateCache(KeyStrokeMap::iterator it);
+    size_t getCacheCapacity() const;
+
+    void computeProfiles(KeyStroke& keyStroke);
+    void computeTangents(KeyStrokeMap::iterator it);
+    void refresh(KeyStrokeMap::iterator it);
+
+    /**
+     * Writes the strokes interpolated between K0 and K1 at count times ts in [0, 1], one after
+     * the other (m_sampling + 1 points each).
+     * Times are processed by batches of TIME_BATCH: for each segment, the inner loops over the
+     * times of a batch blend the angles and the lengths and evaluate sines and cosines with
+     * FastSinCos, without any branch or library call, so that they can be vectorized.
+     */
+    void interpolate(const KeyStroke& K0, const KeyStroke& K1, const float* ts, size_t count, glm::vec3* points) const;
+
+    /**
+     * Writes the stroke interpolated between K0 and K1 at t in [0, 1] (m_sampling + 1 points),
+     * as a parallel prefix sum: the segment vectors of each block of SCAN_GRAIN_SIZE segments are
+     * computed and accumulated in parallel, the block totals are accumulated serially, then added
+     * to the points of the following blocks in parallel.
+     */
+    void interpolateScan(const KeyStroke& K0, const KeyStroke& K1, float t, glm::vec3* points) const;
 
-    CurvePtr interpolate(
-        const CurvePtr& C0, 
-        const CurvePtr& C1, 
-        const CurvePtr& prevC0, 
-        const CurvePtr& nextC1, 
-        float t
-    );
+    static const size_t TIME_BATCH = 16;
+    static const size_t SCAN_GRAIN_SIZE = 4096;
 };
 
 using DynamicSurfacePtr = std::shared_ptr<DynamicSurface>;
@@ -57,21 +57,24 @@ GLSurface::~GLSurface()
 
 void GLSurface::tesselate(size_t xStep, size_t yStep)
 {
-    m_points.clear();
     m_indices.clear();
-
-    m_points.reserve(xStep * yStep);
     m_indices.reserve(2 * xStep * yStep);
 
     m_xStep = xStep;
     m_yStep = yStep;
 
     // Points
+    std::vector<float> us(xStep);
+    std::vector<float> vs(yStep);
+
     float uStep = 1.0f / (xStep - 1);
     float vStep = 1.0f / (yStep - 1);
+    for (size_t u = 0; u < xStep; ++u)
+        us[u] = u * uStep;
     for (size_t v = 0; v < yStep; ++v)
-        for (size_t u = 0; u < xStep; ++u)
-            m_points.push_back(m_surface->evaluate(u * uStep, v * vStep));
+        vs[v] = v * vStep;
+
+    m_surface->evaluateGrid(us, vs, m_points);
 
     // Indices of columns
     for (unsigned int i = 0; i < (unsigned int)xStep * yStep; ++i)
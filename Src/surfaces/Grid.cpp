@@ -53,6 +53,16 @@ glm::vec3 Grid::evaluate(float u, float v)
     return glm::mix(Pv, Qv, u);
 }
 
+AABB Grid::getBounds()
+{
+    AABB bounds;
+    bounds.extend(m_P0);
+    bounds.extend(m_P1);
+    bounds.extend(m_P2);
+    bounds.extend(m_P3);
+    return bounds;
+}
+
 void Grid::draw()
 {
     ShaderProgram& program = *(Viewer::Get().getProgram("point"));
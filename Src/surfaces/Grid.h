@@ -34,6 +34,11 @@ public:
      */
     glm::vec3 evaluate(float u, float v) override;
 
+    /**
+     * Box of the corners, which contains the bilinear patch
+     */
+    AABB getBounds() override;
+
     /**
      * Draws the four corner points
      */
@@ -144,6 +144,72 @@ glm::vec3 HermiteSurface::evaluate(float s, float t)
   return result;
 }
 
+void HermiteSurface::evaluateGrid(const std::vector<float>& ss, const std::vector<float>& ts, std::vector<glm::vec3>& points)
+{
+  if (_time_interpolation != InterpolationMode::linear &&
+      _time_interpolation != InterpolationMode::hermite_from_ctrl_pts)
+  {
+    Surface::evaluateGrid(ss, ts, points);
+    return;
+  }
+
+  // Strokes are sampled once for the whole grid
+  std::vector<std::vector<glm::vec3>> stroke_points;
+  for (HermiteSplinePtr& stroke : _strokes)
+    stroke_points.push_back(stroke->get_points(ss));
+
+  points.resize(ss.size() * ts.size());
+  std::vector<glm::vec3> time_points(_strokes.size());
+  std::vector<glm::vec3> column(ts.size());
+  for (size_t i = 0; i < ss.size(); ++i)
+  {
+    for (size_t k = 0; k < _strokes.size(); ++k)
+      time_points[k] = stroke_points[k][i];
+
+    if (_time_interpolation == InterpolationMode::hermite_from_ctrl_pts)
+      HermiteSpline(time_points).get_points(ts.data(), ts.size(), column.data());
+    else
+      LinearSpline(time_points).get_points(ts.data(), ts.size(), column.data());
+
+    for (size_t j = 0; j < ts.size(); ++j)
+      points[j * ss.size() + i] = column[j];
+  }
+}
+
+AABB HermiteSurface::getBounds()
+{
+  std::vector<AABB> stroke_bounds;
+  for (HermiteSplinePtr& stroke : _strokes)
+    stroke_bounds.push_back(stroke->get_bounds());
+
+  // Linear interpolation stays in the convex hull of the strokes
+  AABB bounds;
+  for (const AABB& box : stroke_bounds)
+    bounds.extend(box);
+
+  if (_time_interpolation != InterpolationMode::hermite_from_ctrl_pts)
+    return bounds;
+
+  // The Catmull-Rom tangent of stroke k is (P[k + 1] - P[k - 1]) / 2 (indices clamped at the ends),
+  // so the inner Bezier control points P[k] + T[k] / 3 and P[k + 1] - T[k + 1] / 3 lie in the sums
+  // of intervals below
+  auto clamped = [&](int k) { return stroke_bounds[glm::clamp(k, 0, (int)stroke_bounds.size() - 1)]; };
+  for (int k = 0; k + 1 < (int)stroke_bounds.size(); ++k)
+  {
+    AABB P = clamped(k);
+    AABB next = clamped(k + 1);
+    AABB prev = clamped(k - 1);
+    bounds.extend(AABB(P.min + (next.min - prev.max) / 6.0f, P.max + (next.max - prev.min) / 6.0f));
+
+    P = clamped(k + 1);
+    next = clamped(k + 2);
+    prev = clamped(k);
+    bounds.extend(AABB(P.min - (next.max - prev.min) / 6.0f, P.max - (next.min - prev.max) / 6.0f));
+  }
+
+  return bounds;
+}
+
 void HermiteSurface::init()
 {
     for (HermiteSplinePtr& keySpline : _strokes)
@@ -29,6 +29,13 @@ class HermiteSurface : public Surface
     void setColor(const glm::vec3& color) { m_color = glm::vec4(color, 1.0f); }
     void setColor(const glm::vec4& color) { m_color = color; }
 
+    /**
+     * Computed from the cached bounds of the strokes. With Hermite interpolation in time, the
+     * boxes of the Bezier control points of the time splines are bounded from those of the strokes,
+     * so the box can be larger than the surface.
+     */
+    AABB getBounds() override;
+
     /**
      * Draws the key hermite splines.
      */
@@ -38,6 +45,7 @@ class HermiteSurface : public Surface
     InterpolationMode _time_interpolation;
     std::vector<HermiteSplinePtr> _strokes;
     glm::vec3 evaluate(float s, float t) override;
+    void evaluateGrid(const std::vector<float>& ss, const std::vector<float>& ts, std::vector<glm::vec3>& points) override;
 
     std::vector<GLCurvePtr> m_keyCurves;
     glm::vec4 m_color;
@@ -2,9 +2,12 @@
 #define __SURFACE_H__
 
 #include <memory>
+#include <vector>
 
 #include <glm/glm.hpp>
 
+#include "utils/AABB.h"
+
 
 class Surface
 {
@@ -16,12 +19,48 @@ public:
 
     virtual glm::vec3 evaluate(float u, float v) = 0;
 
+    /**
+     * Evaluates the surface on the grid us x vs : points[v * us.size() + u] = evaluate(us[u], vs[v])
+     * Implementations should override it to evaluate their input curves in batches.
+     */
+    virtual void evaluateGrid(const std::vector<float>& us, const std::vector<float>& vs, std::vector<glm::vec3>& points)
+    {
+        points.resize(us.size() * vs.size());
+        for (size_t v = 0; v < vs.size(); ++v)
+            for (size_t u = 0; u < us.size(); ++u)
+                points[v * us.size() + u] = evaluate(us[u], vs[v]);
+    }
+
+    /**
+     * Bounding box of the surface over [0, 1] x [0, 1]. Implementations may return a larger box,
+     * and should compute it from cached data (e.g. the bounds of their curves): it is meant to be
+     * queried every frame, for culling or picking.
+     * The default implementation bounds a sampling of the surface, so it is only approximate.
+     */
+    virtual AABB getBounds()
+    {
+        std::vector<float> params(BOUNDS_SAMPLES);
+        for (size_t i = 0; i < BOUNDS_SAMPLES; ++i)
+            params[i] = (float)i / (BOUNDS_SAMPLES - 1);
+
+        std::vector<glm::vec3> points;
+        evaluateGrid(params, params, points);
+
+        AABB bounds;
+        for (const glm::vec3& point : points)
+            bounds.extend(point);
+        return bounds;
+    }
+
     /**
      * If we want to draw specific elements of the surface
      */
     virtual void draw() = 0;
 
 private:
+    // Samples along u and v of the default getBounds
+    static const size_t BOUNDS_SAMPLES = 17;
+
     bool m_drawInputs;
 };
 
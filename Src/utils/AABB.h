@@ -0,0 +1,65 @@
+#ifndef __AABB_H__
+#define __AABB_H__
+
+#include <limits>
+
+#include <glm/glm.hpp>
+
+
+/**
+ * Axis-aligned bounding box. A default constructed box is empty, and extending it by a
+ * point gives the box of this point.
+ */
+struct AABB
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    AABB()
+        : min(std::numeric_limits<float>::max())
+        , max(-std::numeric_limits<float>::max())
+    {}
+
+    AABB(const glm::vec3& min, const glm::vec3& max)
+        : min(min)
+        , max(max)
+    {}
+
+    bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    void extend(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void extend(const AABB& box)
+    {
+        min = glm::min(min, box.min);
+        max = glm::max(max, box.max);
+    }
+
+    glm::vec3 center() const { return 0.5f * (min + max); }
+    glm::vec3 size() const { return max - min; }
+
+    bool contains(const glm::vec3& point) const
+    {
+        return glm::all(glm::lessThanEqual(min, point)) && glm::all(glm::lessThanEqual(point, max));
+    }
+
+    bool intersects(const AABB& box) const
+    {
+        return glm::all(glm::lessThanEqual(min, box.max)) && glm::all(glm::lessThanEqual(box.min, max));
+    }
+
+    /**
+     * Squared distance from the box to a point (0 inside the box)
+     */
+    float distance2(const glm::vec3& point) const
+    {
+        glm::vec3 d = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+};
+
+#endif // __AABB_H__
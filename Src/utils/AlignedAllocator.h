@@ -0,0 +1,69 @@
+#ifndef __ALIGNED_ALLOCATOR_H__
+#define __ALIGNED_ALLOCATOR_H__
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+
+/**
+ * Standard allocator returning memory aligned on Alignment bytes (a power of two, multiple of
+ * sizeof(void*)), e.g. for aligned SIMD loads.
+ */
+template<typename T, size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n)
+    {
+        if (n == 0)
+            return nullptr;
+
+        void* memory = nullptr;
+#ifdef _WIN32
+        memory = _aligned_malloc(n * sizeof(T), Alignment);
+#else
+        if (posix_memalign(&memory, Alignment, n * sizeof(T)) != 0)
+            memory = nullptr;
+#endif
+        if (!memory)
+            throw std::bad_alloc();
+
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* memory, size_t)
+    {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+template<typename T, size_t Alignment = 64>
+using AlignedVector = std::vector<T, AlignedAllocator<T, Alignment>>;
+
+#endif // __ALIGNED_ALLOCATOR_H__
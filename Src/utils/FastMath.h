@@ -0,0 +1,36 @@
+#ifndef __FAST_MATH_H__
+#define __FAST_MATH_H__
+
+
+/**
+ * Sine and cosine of x, with an error below 1e-7 for |x| up to a few thousands.
+ * x is reduced to [-pi/4, pi/4] by a multiple of pi/2 (in three parts, to keep the reduction exact),
+ * then both functions are evaluated by minimax polynomials and swapped or negated according to the
+ * quadrant. There is no branch and no call to the math library, so loops over arrays of angles
+ * can be vectorized by the compiler, unlike calls to std::sin and std::cos.
+ */
+inline void FastSinCos(float x, float& sine, float& cosine)
+{
+    const float TWO_OVER_PI = 0.636619772367581f;
+    const float PI_OVER_2_1 = 1.5703125f;
+    const float PI_OVER_2_2 = 4.837512969970703125e-4f;
+    const float PI_OVER_2_3 = 7.54978995489188216e-8f;
+
+    // Nearest quadrant, rounding by truncation of x +/- 0.5
+    int quadrant = (int)(x * TWO_OVER_PI + (x >= 0.0f ? 0.5f : -0.5f));
+    float q = (float)quadrant;
+    float r = ((x - q * PI_OVER_2_1) - q * PI_OVER_2_2) - q * PI_OVER_2_3;
+    float r2 = r * r;
+
+    float s = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    float c = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+    // sin(r + q pi/2) and cos(r + q pi/2) from the quadrant q mod 4
+    bool swap = (quadrant & 1) != 0;
+    float sinR = swap ? c : s;
+    float cosR = swap ? s : c;
+    sine = (quadrant & 2) ? -sinR : sinR;
+    cosine = ((quadrant + 1) & 2) ? -cosR : cosR;
+}
+
+#endif // __FAST_MATH_H__
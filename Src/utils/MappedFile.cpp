@@ -0,0 +1,148 @@
+#include "utils/MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "utils/Logger.h"
+
+
+// Empty files cannot be mapped: they are opened as this empty buffer
+static const char EMPTY_FILE[1] = { 0 };
+
+MappedFile::MappedFile()
+    : m_data(nullptr)
+    , m_size(0)
+#ifdef _WIN32
+    , m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& fileName)
+{
+    close();
+
+    m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        Logger::Error("MappedFile : failed to open file " + fileName);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size))
+    {
+        Logger::Error("MappedFile : failed to get the size of " + fileName);
+        close();
+        return false;
+    }
+
+    m_size = (size_t)size.QuadPart;
+    if (m_size == 0)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+        m_data = EMPTY_FILE;
+        return true;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping)
+        m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+    if (!m_data)
+    {
+        Logger::Error("MappedFile : failed to map file " + fileName);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data && m_data != EMPTY_FILE)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open(const std::string& fileName)
+{
+    close();
+
+    int file = ::open(fileName.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        Logger::Error("MappedFile : failed to open file " + fileName);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0)
+    {
+        Logger::Error("MappedFile : failed to get the size of " + fileName);
+        ::close(file);
+        return false;
+    }
+
+    if (status.st_size == 0)
+    {
+        ::close(file);
+        m_data = EMPTY_FILE;
+        return true;
+    }
+
+    // The mapping stays valid once the descriptor is closed
+    void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+
+    if (data == MAP_FAILED)
+    {
+        Logger::Error("MappedFile : failed to map file " + fileName);
+        return false;
+    }
+
+    m_data = static_cast<const char*>(data);
+    m_size = (size_t)status.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data && m_data != EMPTY_FILE)
+        munmap(const_cast<char*>(m_data), m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
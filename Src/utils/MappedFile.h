@@ -0,0 +1,40 @@
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include <memory>
+#include <string>
+
+
+/**
+ * Read-only memory mapping of a whole file. Empty files are opened, with a size of 0.
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& fileName);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t m_size;
+
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#endif
+};
+
+using MappedFilePtr = std::shared_ptr<MappedFile>;
+
+#endif // __MAPPEDFILE_H__
@@ -0,0 +1,139 @@
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+
+namespace
+{
+    // Ranges of a parallelFor, processed by whichever threads pick them
+    struct ParallelRanges
+    {
+        const std::function<void(size_t, size_t)>* task;
+        size_t count;
+        size_t grainSize;
+        size_t rangeCount;
+
+        std::atomic<size_t> next;
+        std::atomic<size_t> done;
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr exception;
+
+        void process()
+        {
+            size_t range;
+            while ((range = next++) < rangeCount)
+            {
+                size_t begin = range * grainSize;
+                try
+                {
+                    (*task)(begin, std::min(begin + grainSize, count));
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!exception)
+                        exception = std::current_exception();
+                }
+
+                if (++done == rangeCount)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.notify_all();
+                }
+            }
+        }
+    };
+}
+
+
+ThreadPool& ThreadPool::Get()
+{
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : m_stopping(false)
+{
+    for (size_t i = 0; i < threadCount; ++i)
+        m_threads.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+
+void ThreadPool::run()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& task)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    size_t rangeCount = (count + grainSize - 1) / grainSize;
+    if (rangeCount == 1 || m_threads.empty())
+    {
+        task(0, count);
+        return;
+    }
+
+    auto ranges = std::make_shared<ParallelRanges>();
+    ranges->task = &task;
+    ranges->count = count;
+    ranges->grainSize = grainSize;
+    ranges->rangeCount = rangeCount;
+    ranges->next = 0;
+    ranges->done = 0;
+
+    // The calling thread processes ranges too: nested calls from the pool threads cannot starve,
+    // and helpers starting after the last range just return
+    size_t helpers = std::min(rangeCount - 1, m_threads.size());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < helpers; ++i)
+            m_jobs.push_back([ranges]() { ranges->process(); });
+    }
+    m_condition.notify_all();
+
+    ranges->process();
+
+    {
+        std::unique_lock<std::mutex> lock(ranges->mutex);
+        ranges->finished.wait(lock, [&ranges]() { return ranges->done == ranges->rangeCount; });
+    }
+
+    if (ranges->exception)
+        std::rethrow_exception(ranges->exception);
+}
@@ -0,0 +1,47 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool
+{
+public:
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Pool shared by the application, with one thread per hardware thread but the calling one.
+     * It is created on first use.
+     */
+    static ThreadPool& Get();
+
+    size_t getThreadCount() const { return m_threads.size(); }
+
+    /**
+     * Calls task(begin, end) on ranges of at most grainSize indices covering [0, count[, on the
+     * pool threads and the calling thread, and returns when all of them are processed.
+     * Tasks can call parallelFor themselves. The first exception thrown by a task is rethrown.
+     */
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& task);
+
+private:
+    ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    void run();
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::function<void()>> m_jobs;
+    bool m_stopping;
+};
+
+#endif // __THREADPOOL_H__
@@ -0,0 +1,153 @@
+/**
+ * Stress test of the thread-safety contract of Curve (see Curve.h): several threads evaluate and
+ * query the same curves concurrently, and their results are compared with a serial reference.
+ * The segment hierarchy is built lazily by the first query, so threads also race on get_bvh,
+ * and closest_points runs nested parallel loops on the ThreadPool.
+ *
+ * This driver is not part of the Visual Studio solution. Build and run it under ThreadSanitizer
+ * from the repository root:
+ *
+ *   g++ -std=c++14 -O1 -g -fsanitize=thread -pthread -IDependencies/include -ISrc \
+ *       Tests/CurveThreadStress.cpp Src/curves/{Curve,CurveBVH,HermiteSpline,LinearSpline,SoAPoints}.cpp \
+ *       Src/utils/{Logger,ThreadPool}.cpp -o CurveThreadStress && ./CurveThreadStress
+ *
+ * It returns 0 when all results match, and ThreadSanitizer reports any data race.
+ */
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "curves/HermiteSpline.h"
+#include "curves/LinearSpline.h"
+
+
+static const size_t THREAD_COUNT = 8;
+static const size_t ITERATION_COUNT = 20;
+static const size_t SAMPLE_COUNT = 512;
+
+static std::vector<glm::vec3> makePoints(size_t count)
+{
+    std::vector<glm::vec3> points(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float a = 0.05f * i;
+        points[i] = glm::vec3(std::cos(a) * (1.0f + 0.01f * i), std::sin(a) * (1.0f + 0.01f * i), 0.02f * i);
+    }
+    return points;
+}
+
+/**
+ * Everything a thread computes from a curve, in the order of the calls
+ */
+struct Results
+{
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> batch;
+    std::vector<glm::vec3> uniform;
+    std::vector<glm::vec3> arcLength;
+    std::vector<glm::vec3> derivatives;
+    std::vector<CurvePoint> closest;
+    AABB bounds;
+};
+
+static Results evaluate(const Curve& curve, const std::vector<float>& params, const std::vector<glm::vec3>& queries)
+{
+    Results results;
+
+    Curve::Cursor cursor(curve);
+    for (float param : params)
+        results.points.push_back(cursor(param));
+
+    results.batch = curve.get_points(params);
+    results.uniform = curve.resample_uniform(SAMPLE_COUNT);
+    results.arcLength = curve.resample_arc_length(SAMPLE_COUNT);
+
+    results.derivatives.resize(params.size());
+    curve.get_derivatives(params.data(), params.size(), results.derivatives.data());
+
+    results.closest = curve.closest_points(queries);
+    results.bounds = curve.get_bounds();
+    return results;
+}
+
+static bool equal(const Results& a, const Results& b)
+{
+    if (a.points != b.points || a.batch != b.batch || a.uniform != b.uniform || a.arcLength != b.arcLength ||
+        a.derivatives != b.derivatives || a.bounds.min != b.bounds.min || a.bounds.max != b.bounds.max ||
+        a.closest.size() != b.closest.size())
+        return false;
+
+    for (size_t i = 0; i < a.closest.size(); ++i)
+    {
+        if (a.closest[i].param != b.closest[i].param || a.closest[i].point != b.closest[i].point)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Evaluates the curve from THREAD_COUNT threads, starting with no segment hierarchy.
+ * Returns the number of results differing from the serial reference.
+ */
+static size_t stress(const char* name, const std::function<CurvePtr()>& create)
+{
+    std::vector<float> params(SAMPLE_COUNT);
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i)
+        params[i] = float(i) / (SAMPLE_COUNT - 1);
+
+    std::vector<glm::vec3> queries(SAMPLE_COUNT);
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i)
+        queries[i] = glm::vec3(std::cos(0.1f * i) * 2.0f, std::sin(0.13f * i) * 2.0f, 0.01f * i);
+
+    Results reference = evaluate(*create(), params, queries);
+
+    std::atomic<size_t> failures(0);
+    for (size_t iteration = 0; iteration < ITERATION_COUNT; ++iteration)
+    {
+        CurvePtr curve = create();
+
+        std::atomic<size_t> ready(0);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < THREAD_COUNT; ++i)
+        {
+            threads.emplace_back([&]()
+            {
+                // Start together, so that the first queries race on the lazy initializations
+                ++ready;
+                while (ready < THREAD_COUNT)
+                    std::this_thread::yield();
+
+                if (!equal(evaluate(*curve, params, queries), reference))
+                    ++failures;
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    std::printf("%s: %zu threads x %zu iterations, %zu mismatches\n", name, THREAD_COUNT, ITERATION_COUNT,
+                failures.load());
+    return failures;
+}
+
+int main()
+{
+    std::vector<glm::vec3> points = makePoints(200);
+
+    size_t failures = 0;
+    failures += stress("HermiteSpline", [&]() { return std::make_shared<HermiteSpline>(points); });
+    failures += stress("HermiteSpline (SoA)", [&]()
+    {
+        auto spline = std::make_shared<HermiteSpline>(points);
+        spline->set_soa_storage(true);
+        spline->set_arc_length_resolution(8);
+        return spline;
+    });
+    failures += stress("LinearSpline", [&]() { return std::make_shared<LinearSpline>(points); });
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/**
+ * Benchmark of the Hermite kernels (see HermiteBasis.h) and splines (see HermiteSplineT.h)
+ * instantiated on float and double, in 2D and 3D:
+ * - throughput of Hermite on the segments of a long stroke, and error of the float instantiations
+ *   against the double ones, for coordinates near the origin and far from it (e.g. CAD strokes in
+ *   world units);
+ * - construction (segment lengths and params) and batch evaluation of HermiteSpline and of the
+ *   HermiteSplineT instantiations on the same stroke. HermiteSpline3f must match HermiteSpline
+ *   exactly, as both run the same evaluation core.
+ *
+ * This driver is not part of the Visual Studio solution. Build and run it from the repository
+ * root with optimizations:
+ *
+ *   g++ -std=c++14 -O2 -pthread -IDependencies/include -ISrc Tests/HermiteKernelBenchmark.cpp \
+ *       Src/curves/{Curve,CurveBVH,HermiteSpline,SoAPoints}.cpp Src/utils/{Logger,ThreadPool}.cpp \
+ *       -o HermiteKernelBenchmark && ./HermiteKernelBenchmark
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "curves/HermiteBasis.h"
+#include "curves/HermiteSpline.h"
+#include "curves/HermiteSplineT.h"
+
+
+static const size_t POINT_COUNT = 10000;
+static const size_t SAMPLES_PER_SEGMENT = 400;
+static const int RUN_COUNT = 9;
+
+// Params evaluated by get_points in the spline benchmark
+static const size_t PARAM_COUNT = 1 << 22;
+
+/**
+ * Catmull-Rom stroke in double precision, offset by origin on each axis
+ */
+template<typename V>
+static void makeStroke(double origin, std::vector<V>& points, std::vector<V>& tangents)
+{
+    points.resize(POINT_COUNT);
+    for (size_t i = 0; i < POINT_COUNT; ++i)
+    {
+        double a = 0.01 * i;
+        V P(origin);
+        P[0] += 0.05 * i + std::cos(3.0 * a);
+        P[1] += std::sin(a) * (1.0 + 0.1 * std::sin(7.0 * a));
+        if (P.length() == 3)
+            P[2] += 0.2 * std::sin(5.0 * a);
+        points[i] = P;
+    }
+
+    tangents.resize(POINT_COUNT);
+    for (size_t i = 0; i < POINT_COUNT; ++i)
+        tangents[i] = 0.5 * (points[std::min(i + 1, POINT_COUNT - 1)] - points[i > 0 ? i - 1 : 0]);
+}
+
+template<typename To, typename From>
+static std::vector<To> convert(const std::vector<From>& vectors)
+{
+    return std::vector<To>(vectors.begin(), vectors.end());
+}
+
+/**
+ * Evaluates every segment at SAMPLES_PER_SEGMENT params. Returns the best time in ms, and writes
+ * the points of the last run.
+ */
+template<typename V, typename S>
+static double evaluate(const std::vector<V>& points, const std::vector<V>& tangents, std::vector<V>& samples)
+{
+    samples.resize((POINT_COUNT - 1) * SAMPLES_PER_SEGMENT);
+
+    double best = 1e9;
+    for (int run = 0; run < RUN_COUNT; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        V* out = samples.data();
+        for (size_t i = 0; i + 1 < POINT_COUNT; ++i)
+        {
+            for (size_t j = 0; j < SAMPLES_PER_SEGMENT; ++j)
+                *out++ = Hermite<V, S>(points[i], points[i + 1], tangents[i], tangents[i + 1], S(j) / SAMPLES_PER_SEGMENT);
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+template<typename A, typename B>
+static double maxDistance(const std::vector<A>& a, const std::vector<B>& b)
+{
+    double distance = 0.0;
+    for (size_t i = 0; i < a.size(); ++i)
+        distance = std::max(distance, glm::length(B(a[i]) - b[i]));
+    return distance;
+}
+
+/**
+ * Benchmarks V (float) and DV (double) vectors of the same dimension
+ */
+template<typename V, typename DV>
+static void benchmark(const char* name, double origin)
+{
+    std::vector<DV> pointsD, tangentsD;
+    makeStroke(origin, pointsD, tangentsD);
+    std::vector<V> points = convert<V>(pointsD);
+    std::vector<V> tangents = convert<V>(tangentsD);
+
+    std::vector<V> samples;
+    std::vector<DV> samplesD;
+    double timeF = evaluate<V, float>(points, tangents, samples);
+    double timeD = evaluate<DV, double>(pointsD, tangentsD, samplesD);
+
+    double lengthF = 0.0, lengthD = 0.0;
+    for (size_t i = 0; i + 1 < POINT_COUNT; ++i)
+    {
+        lengthF += HermiteAdaptiveLength<V, float>(points[i], points[i + 1], tangents[i], tangents[i + 1], 1e-4f, 8);
+        lengthD += HermiteAdaptiveLength<DV, double>(pointsD[i], pointsD[i + 1], tangentsD[i], tangentsD[i + 1], 1e-8, 8);
+    }
+
+    std::printf("%s, origin %g: float %.1f ms, double %.1f ms, float point error %.3g, float length error %.3g\n",
+                name, origin, timeF, timeD, maxDistance(samples, samplesD), std::abs(lengthF - lengthD) / lengthD);
+}
+
+/**
+ * Best time over RUN_COUNT runs of f, in ms
+ */
+template<typename F>
+static double bestTime(F f)
+{
+    double best = 1e9;
+    for (int run = 0; run < RUN_COUNT; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * Builds the spline SplineT on the stroke, and evaluates it at PARAM_COUNT sorted params.
+ * Prints the times, and the distance of the points to the reference (the same spline in double).
+ */
+template<typename SplineT, typename DV>
+static void benchmarkSpline(const char* name, const std::vector<DV>& pointsD, const std::vector<DV>& reference)
+{
+    using S = typename SplineT::Scalar;
+    using V = typename SplineT::Vector;
+
+    std::vector<V> points = convert<V>(pointsD);
+    SplineT spline;
+    double buildTime = bestTime([&]() { spline.set_points(points); });
+
+    std::vector<S> params(PARAM_COUNT);
+    for (size_t i = 0; i < PARAM_COUNT; ++i)
+        params[i] = S(i) / (PARAM_COUNT - 1);
+
+    std::vector<V> samples(PARAM_COUNT);
+    double evaluationTime = bestTime([&]() { spline.get_points(params.data(), PARAM_COUNT, samples.data()); });
+
+    std::printf("  %-15s build %6.2f ms, get_points %6.1f ms, distance to double %.3g\n", name, buildTime,
+                evaluationTime, maxDistance(samples, reference));
+}
+
+/**
+ * HermiteSpline (the float 3D Curve) and the HermiteSplineT instantiations on the same stroke
+ */
+static void benchmarkSplines(double origin)
+{
+    std::vector<glm::dvec3> pointsD, tangentsD;
+    makeStroke(origin, pointsD, tangentsD);
+    std::vector<glm::dvec2> points2D(pointsD.begin(), pointsD.end());
+
+    std::vector<double> params(PARAM_COUNT);
+    for (size_t i = 0; i < PARAM_COUNT; ++i)
+        params[i] = double(i) / (PARAM_COUNT - 1);
+    std::vector<glm::dvec3> reference = HermiteSpline3d(pointsD).get_points(params);
+    std::vector<glm::dvec2> reference2D = HermiteSpline2d(points2D).get_points(params);
+
+    std::printf("Splines, origin %g: %zu params\n", origin, PARAM_COUNT);
+    benchmarkSpline<HermiteSpline3d>("HermiteSpline3d", pointsD, reference);
+    benchmarkSpline<HermiteSpline3f>("HermiteSpline3f", pointsD, reference);
+    benchmarkSpline<HermiteSpline2d>("HermiteSpline2d", points2D, reference2D);
+    benchmarkSpline<HermiteSpline2f>("HermiteSpline2f", points2D, reference2D);
+
+    std::vector<glm::vec3> points = convert<glm::vec3>(pointsD);
+    HermiteSpline curve;
+    HermiteSpline3f spline(points);
+
+    std::vector<float> paramsF(params.begin(), params.end());
+    std::vector<glm::vec3> curveSamples(PARAM_COUNT);
+    double buildTime = bestTime([&]() { curve.set_points(points); });
+    double evaluationTime = bestTime([&]() { curve.get_points(paramsF.data(), PARAM_COUNT, curveSamples.data()); });
+
+    size_t mismatches = (curve.get_params() != spline.get_params());
+    std::vector<glm::vec3> splineSamples = spline.get_points(paramsF);
+    for (size_t i = 0; i < PARAM_COUNT; ++i)
+        mismatches += (curveSamples[i] != splineSamples[i]);
+
+    std::printf("  %-15s build %6.2f ms, get_points %6.1f ms, %zu differences with HermiteSpline3f\n", "HermiteSpline",
+                buildTime, evaluationTime, mismatches);
+}
+
+int main()
+{
+    std::printf("%zu segments x %zu params, best of %d runs\n", POINT_COUNT - 1, SAMPLES_PER_SEGMENT, RUN_COUNT);
+    for (double origin : { 0.0, 1e4 })
+    {
+        benchmark<glm::vec2, glm::dvec2>("2D", origin);
+        benchmark<glm::vec3, glm::dvec3>("3D", origin);
+    }
+    for (double origin : { 0.0, 1e4 })
+        benchmarkSplines(origin);
+    return 0;
+}
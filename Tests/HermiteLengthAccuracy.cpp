@@ -0,0 +1,124 @@
+/**
+ * Accuracy and cost of the Hermite segment lengths (see HermiteSpline::set_length_tolerance), on a
+ * 1M-point spline with irregular, sharply curving segments. For each length tolerance, the driver
+ * times the computation of the params, and compares the segment lengths with a reference polyline
+ * of REFERENCE_SAMPLES samples per segment, evaluated in double precision.
+ * The former 20-sample polyline is measured the same way, as a baseline.
+ *
+ * This driver is not part of the Visual Studio solution. Build and run it from the repository
+ * root with optimizations:
+ *
+ *   g++ -std=c++14 -O2 -pthread -IDependencies/include -ISrc Tests/HermiteLengthAccuracy.cpp \
+ *       Src/curves/{Curve,CurveBVH,HermiteSpline,SoAPoints}.cpp Src/utils/{Logger,ThreadPool}.cpp \
+ *       -o HermiteLengthAccuracy && ./HermiteLengthAccuracy
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "curves/HermiteSpline.h"
+
+
+static const size_t POINT_COUNT = 1000000;
+
+// The reference is computed on every REFERENCE_STRIDE-th segment, with this many samples each
+static const size_t REFERENCE_STRIDE = 100;
+static const size_t REFERENCE_SAMPLES = 4096;
+
+static const size_t BASELINE_SAMPLES = 20;
+
+/**
+ * Stroke with irregular steps and random jitter, so that Catmull-Rom segments range from nearly
+ * straight to tight loops
+ */
+static std::vector<glm::vec3> makePoints()
+{
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> step(0.01f, 1.0f);
+    std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+
+    std::vector<glm::vec3> points(POINT_COUNT);
+    float x = 0.0f;
+    for (size_t i = 0; i < POINT_COUNT; ++i)
+    {
+        x += step(generator);
+        points[i] = glm::vec3(x + jitter(generator), std::sin(0.01f * i) * 10.0f + jitter(generator), jitter(generator));
+    }
+    return points;
+}
+
+/**
+ * Length of the polyline through samples + 1 points of segment i, evaluated in double precision
+ */
+static double polylineLength(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& tangents, size_t i,
+                             size_t samples)
+{
+    glm::dvec3 P0(points[i]), P1(points[i + 1]), T0(tangents[i]), T1(tangents[i + 1]);
+
+    double length = 0.0;
+    glm::dvec3 previous = P0;
+    for (size_t k = 1; k <= samples; ++k)
+    {
+        glm::dvec3 P = Hermite<glm::dvec3, double>(P0, P1, T0, T1, double(k) / samples);
+        length += glm::length(P - previous);
+        previous = P;
+    }
+    return length;
+}
+
+/**
+ * Maximum relative error of lengths (one per segment) against the reference segments
+ */
+template<typename L>
+static double maxError(const std::vector<L>& lengths, const std::vector<double>& reference)
+{
+    double error = 0.0;
+    for (size_t j = 0; j < reference.size(); ++j)
+    {
+        if (reference[j] > 0.0)
+            error = std::max(error, std::abs(lengths[j * REFERENCE_STRIDE] - reference[j]) / reference[j]);
+    }
+    return error;
+}
+
+int main()
+{
+    std::vector<glm::vec3> points = makePoints();
+    HermiteSpline spline(points);
+    const std::vector<glm::vec3>& tangents = spline.get_tangents();
+
+    std::vector<double> reference;
+    for (size_t i = 0; i + 1 < POINT_COUNT; i += REFERENCE_STRIDE)
+        reference.push_back(polylineLength(points, tangents, i, REFERENCE_SAMPLES));
+
+    std::printf("%zu points, reference on %zu segments with %zu samples each\n", POINT_COUNT, reference.size(),
+                REFERENCE_SAMPLES);
+
+    // Baseline: the former fixed polyline approximation
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> lengths(POINT_COUNT - 1);
+        for (size_t i = 0; i + 1 < POINT_COUNT; ++i)
+            lengths[i] = polylineLength(points, tangents, i, BASELINE_SAMPLES);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::printf("%zu-sample polyline: %.1f ms, max relative error %.3g\n", BASELINE_SAMPLES, elapsed.count(),
+                    maxError(lengths, reference));
+    }
+
+    for (float tolerance : { 1e-2f, 1e-3f, 1e-4f, 1e-5f, 1e-6f })
+    {
+        // set_length_tolerance recomputes the lengths and the params
+        auto start = std::chrono::steady_clock::now();
+        spline.set_length_tolerance(tolerance);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::printf("Gauss-Legendre, tolerance %g%s: %.1f ms, max relative error %.3g\n", tolerance,
+                    tolerance == 1e-4f ? " (default)" : "", elapsed.count(), maxError(spline.get_lengths(), reference));
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+/**
+ * Benchmark of the reconstruction of the strokes of DynamicSurface::interpolate(t), serial or as a
+ * parallel prefix sum (see DynamicSurface::setParallelScanMinSampling), from 1k to 1M segments.
+ * Each path is forced in turn on the same surface with the cache disabled, so the times include
+ * the whole call (profiles lookup and LinearSpline of the points).
+ *
+ * The key strokes are two lines of length 1, along X at time 0 and along Y at time 1: the stroke
+ * at time 0.5 is the line at 45 degrees whose points are at the distances of the samples of the
+ * key strokes, which gives an exact reference for the accumulation error of both paths.
+ *
+ * The scan only pays off when the pool has threads to run its blocks on (see
+ * ThreadPool::getThreadCount): with none, it runs inline and the times measure its overhead.
+ *
+ * This driver is not part of the Visual Studio solution. Build and run it from the repository
+ * root with optimizations:
+ *
+ *   g++ -std=c++14 -O2 -pthread -IDependencies/include -ISrc Tests/InterpolateScanBenchmark.cpp \
+ *       Src/surfaces/DynamicSurface.cpp Src/curves/{Curve,CurveBVH,HermiteSpline,LinearSpline,SoAPoints}.cpp \
+ *       Src/utils/{Logger,ThreadPool}.cpp -o InterpolateScanBenchmark && ./InterpolateScanBenchmark
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+#include "curves/HermiteSpline.h"
+#include "surfaces/DynamicSurface.h"
+#include "utils/ThreadPool.h"
+
+
+static const int RUN_COUNT = 7;
+
+static CurvePtr makeLine(const glm::vec3& direction)
+{
+    return std::make_shared<HermiteSpline>(std::vector<glm::vec3> { glm::vec3(0.0f), direction },
+                                           std::vector<glm::vec3> { direction, direction });
+}
+
+/**
+ * Interpolates the surface at time 0.5 RUN_COUNT times. Returns the best time in ms, and the
+ * stroke of the last run.
+ */
+static double bestTime(DynamicSurface& surface, CurvePtr& stroke)
+{
+    double best = 1e30;
+    for (int run = 0; run < RUN_COUNT; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        stroke = surface.interpolate(0.5f);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * Maximum distance between the points of the stroke and the reference line
+ */
+static double maxError(const CurvePtr& stroke, const std::vector<double>& distances)
+{
+    std::vector<glm::vec3> points = stroke->getControlPoints();
+    const double direction = std::sqrt(0.5);
+
+    double error = 0.0;
+    for (size_t i = 0; i < distances.size(); ++i)
+    {
+        double x = points[i].x - distances[i] * direction;
+        double y = points[i].y - distances[i] * direction;
+        error = std::max(error, std::sqrt(x * x + y * y + double(points[i].z) * points[i].z));
+    }
+    return error;
+}
+
+int main()
+{
+    CurvePtr lineX = makeLine(glm::vec3(1.0f, 0.0f, 0.0f));
+    CurvePtr lineY = makeLine(glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::printf("%zu pool threads, default cutoff %zu segments, best of %d runs\n", ThreadPool::Get().getThreadCount(),
+                DynamicSurface::DEFAULT_PARALLEL_SCAN_MIN_SAMPLING, RUN_COUNT);
+    std::printf("  segments   serial (ms)  scan (ms)  serial error  scan error\n");
+
+    for (size_t sampling : { 1000, 2000, 4000, 8192, 16000, 64000, 256000, 1000000 })
+    {
+        DynamicSurface surface(sampling);
+        surface.addKeyStroke(0.0f, lineX);
+        surface.addKeyStroke(1.0f, lineY);
+
+        // Samples along X are exact differences of floats: the segment lengths add up to them
+        std::vector<glm::vec3> samples = lineX->resample_uniform(sampling + 1);
+        std::vector<double> distances(samples.size());
+        for (size_t i = 0; i < samples.size(); ++i)
+            distances[i] = double(samples[i].x) - samples[0].x;
+
+        CurvePtr serial, scan;
+        surface.setParallelScanMinSampling(std::numeric_limits<size_t>::max());
+        double serialTime = bestTime(surface, serial);
+        surface.setParallelScanMinSampling(0);
+        double scanTime = bestTime(surface, scan);
+
+        std::printf("  %8zu   %11.3f  %9.3f  %12.3g  %10.3g%s\n", sampling, serialTime, scanTime,
+                    maxError(serial, distances), maxError(scan, distances),
+                    sampling >= DynamicSurface::DEFAULT_PARALLEL_SCAN_MIN_SAMPLING ? "  (scan by default)" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * Benchmark of the segment search of spline evaluation (see Curve::find_segment), on Hermite
+ * splines of 10 to 1M control points: the former linear scan of the params, against get_point
+ * with a binary search (random params), and against a Curve::Cursor whose segment hint makes
+ * increasing params O(1).
+ *
+ * This driver is not part of the Visual Studio solution. Build and run it from the repository
+ * root with optimizations:
+ *
+ *   g++ -std=c++14 -O2 -pthread -IDependencies/include -ISrc Tests/SegmentSearchBenchmark.cpp \
+ *       Src/curves/{Curve,CurveBVH,HermiteSpline,SoAPoints}.cpp Src/utils/{Logger,ThreadPool}.cpp \
+ *       -o SegmentSearchBenchmark && ./SegmentSearchBenchmark
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "curves/HermiteSpline.h"
+
+
+static const size_t QUERY_COUNT = 100000;
+
+// The linear scan is quadratic: its queries are limited to about this many param comparisons
+static const double LINEAR_SCAN_BUDGET = 2e8;
+
+static const int RUN_COUNT = 3;
+
+static std::vector<glm::vec3> makePoints(size_t count)
+{
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> step(0.1f, 2.0f);
+
+    // Unevenly spaced points, so that the params are not uniform
+    std::vector<glm::vec3> points(count);
+    float x = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        x += step(generator);
+        points[i] = glm::vec3(x, std::sin(0.1f * i), std::cos(0.07f * i));
+    }
+    return points;
+}
+
+/**
+ * HermiteSpline::get_point before the segment search: scans the params from the start
+ */
+static glm::vec3 linearScanPoint(const HermiteSpline& spline, const std::vector<glm::vec3>& points, float param)
+{
+    const std::vector<float>& params = spline.get_params();
+    const std::vector<glm::vec3>& tangents = spline.get_tangents();
+
+    if (param <= 0.0f)
+        return points.front();
+    if (param >= 1.0f)
+        return points.back();
+
+    for (size_t i = 1; i < params.size(); ++i)
+    {
+        if (param < params[i])
+        {
+            float t = (param - params[i - 1]) / (params[i] - params[i - 1]);
+            return Hermite<glm::vec3>(points[i - 1], points[i], tangents[i - 1], tangents[i], t);
+        }
+    }
+    return points.back();
+}
+
+/**
+ * Best time over RUN_COUNT runs of evaluate, in ns per query
+ */
+template<typename Evaluate>
+static double nsPerQuery(size_t count, Evaluate evaluate)
+{
+    double best = 1e30;
+    for (int run = 0; run < RUN_COUNT; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        evaluate();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / count);
+    }
+    return best;
+}
+
+int main()
+{
+    std::printf("%8s %14s %14s %14s %10s\n", "points", "linear (ns)", "binary (ns)", "hinted (ns)", "mismatches");
+
+    for (size_t pointCount = 10; pointCount <= 1000000; pointCount *= 10)
+    {
+        std::vector<glm::vec3> points = makePoints(pointCount);
+        HermiteSpline spline(points);
+
+        std::mt19937 generator(2);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        std::vector<float> randomParams(QUERY_COUNT);
+        for (float& param : randomParams)
+            param = uniform(generator);
+
+        std::vector<float> sortedParams(QUERY_COUNT);
+        for (size_t i = 0; i < QUERY_COUNT; ++i)
+            sortedParams[i] = float(i) / (QUERY_COUNT - 1);
+
+        size_t linearCount = std::min(QUERY_COUNT, std::max<size_t>(100, size_t(LINEAR_SCAN_BUDGET / pointCount)));
+
+        std::vector<glm::vec3> linear(QUERY_COUNT), binary(QUERY_COUNT), hinted(QUERY_COUNT);
+        double linearTime = nsPerQuery(linearCount, [&]()
+        {
+            for (size_t i = 0; i < linearCount; ++i)
+                linear[i] = linearScanPoint(spline, points, randomParams[i]);
+        });
+        double binaryTime = nsPerQuery(QUERY_COUNT, [&]()
+        {
+            for (size_t i = 0; i < QUERY_COUNT; ++i)
+                binary[i] = spline.get_point(randomParams[i]);
+        });
+        double hintedTime = nsPerQuery(QUERY_COUNT, [&]()
+        {
+            Curve::Cursor cursor(spline);
+            for (size_t i = 0; i < QUERY_COUNT; ++i)
+                hinted[i] = cursor(sortedParams[i]);
+        });
+
+        // The searches must find the segments of the linear scan
+        size_t mismatches = 0;
+        for (size_t i = 0; i < linearCount; ++i)
+            mismatches += (linear[i] != binary[i]);
+        for (size_t i = 0; i < QUERY_COUNT; i += std::max<size_t>(1, QUERY_COUNT / linearCount))
+            mismatches += (linearScanPoint(spline, points, sortedParams[i]) != hinted[i]);
+
+        std::printf("%8zu %14.1f %14.1f %14.1f %10zu\n", pointCount, linearTime, binaryTime, hintedTime, mismatches);
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * Benchmark of the evaluation throughput of HermiteSpline with its default array of structures
+ * storage (glm::vec3 points and tangents) and with the structure of arrays storage (see
+ * HermiteSpline::set_soa_storage). The same batch of sorted params goes through both outputs of
+ * get_points (interleaved glm::vec3, and one array per coordinate) with each storage, with dense
+ * batches (many params per segment) and sparse ones (about one param per segment).
+ *
+ * This driver is not part of the Visual Studio solution. Build and run it from the repository
+ * root with optimizations (add e.g. -mavx2 to let the compiler use wider vectors):
+ *
+ *   g++ -std=c++14 -O2 -pthread -IDependencies/include -ISrc Tests/SoAEvaluationBenchmark.cpp \
+ *       Src/curves/{Curve,CurveBVH,HermiteSpline,SoAPoints}.cpp Src/utils/{Logger,ThreadPool}.cpp \
+ *       -o SoAEvaluationBenchmark && ./SoAEvaluationBenchmark
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "curves/HermiteSpline.h"
+
+
+static const size_t PARAM_COUNT = 1 << 20;
+static const int RUN_COUNT = 9;
+
+static std::vector<glm::vec3> makePoints(size_t count)
+{
+    std::vector<glm::vec3> points(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float a = 0.05f * i;
+        points[i] = glm::vec3(0.1f * i + std::cos(a), std::sin(a), std::sin(0.3f * a));
+    }
+    return points;
+}
+
+/**
+ * Best time over RUN_COUNT runs of evaluate, in ms
+ */
+template<typename Evaluate>
+static double bestTime(Evaluate evaluate)
+{
+    double best = 1e30;
+    for (int run = 0; run < RUN_COUNT; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        evaluate();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * Evaluates the params with the current storage of the spline, and compares the results with the
+ * reference points. Prints the time of both outputs of get_points.
+ */
+static void benchmark(const HermiteSpline& spline, const std::vector<float>& params,
+                      const std::vector<glm::vec3>& reference, const char* storage)
+{
+    std::vector<glm::vec3> points(params.size());
+    std::vector<float> xs(params.size()), ys(params.size()), zs(params.size());
+
+    double aosTime = bestTime([&]() { spline.get_points(params.data(), params.size(), points.data()); });
+    double soaTime = bestTime([&]() { spline.get_points(params.data(), params.size(), xs.data(), ys.data(), zs.data()); });
+
+    float difference = 0.0f;
+    for (size_t i = 0; i < params.size(); ++i)
+    {
+        difference = std::max(difference, glm::length(points[i] - reference[i]));
+        difference = std::max(difference, glm::length(glm::vec3(xs[i], ys[i], zs[i]) - reference[i]));
+    }
+
+    std::printf("  %-6s storage: vec3 output %6.2f ms (%5.0f M/s), xyz arrays output %6.2f ms (%5.0f M/s), "
+                "max difference %.3g\n", storage, aosTime, params.size() / aosTime * 1e-3, soaTime,
+                params.size() / soaTime * 1e-3, difference);
+}
+
+int main()
+{
+    std::printf("%zu sorted params, best of %d runs\n", PARAM_COUNT, RUN_COUNT);
+
+    for (size_t pointCount : { size_t(1000), PARAM_COUNT })
+    {
+        HermiteSpline spline(makePoints(pointCount));
+
+        std::vector<float> params(PARAM_COUNT);
+        for (size_t i = 0; i < PARAM_COUNT; ++i)
+            params[i] = float(i) / (PARAM_COUNT - 1);
+
+        std::vector<glm::vec3> reference = spline.get_points(params);
+
+        std::printf("%zu control points (%.1f params per segment)\n", pointCount, double(PARAM_COUNT) / (pointCount - 1));
+        spline.set_soa_storage(false);
+        benchmark(spline, params, reference, "AoS");
+        spline.set_soa_storage(true);
+        benchmark(spline, params, reference, "SoA");
+    }
+    return 0;
+}
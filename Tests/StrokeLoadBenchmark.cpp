@@ -0,0 +1,147 @@
+/**
+ * Benchmark of stroke loading (see StrokeFile): text stroke files parsed with getline and a
+ * stringstream per line (the former loadSplineFromFile), parsed by StrokeFile::readText, and
+ * converted once to a binary stroke file that is then mapped. All the loaders must return the
+ * same points.
+ *
+ * Files are written to the working directory and removed afterwards. They are read back from the
+ * page cache, so the times measure parsing rather than the disk.
+ *
+ * This driver is not part of the Visual Studio solution. Build and run it from the repository
+ * root with optimizations:
+ *
+ *   g++ -std=c++14 -O2 -pthread -IDependencies/include -ISrc Tests/StrokeLoadBenchmark.cpp \
+ *       Src/curves/{Curve,CurveBVH,HermiteSpline,LinearSpline,SoAPoints,StrokeFile}.cpp \
+ *       Src/utils/{Logger,MappedFile,ThreadPool}.cpp -o StrokeLoadBenchmark && ./StrokeLoadBenchmark
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "curves/StrokeFile.h"
+
+
+static const char* BINARY_FILE = "StrokeLoadBenchmark.strk";
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * Writes strokeCount text files of pointCount points, with 9 significant digits so that the
+ * points read back exactly
+ */
+static std::vector<std::string> writeTextFiles(size_t strokeCount, size_t pointCount)
+{
+    std::vector<std::string> fileNames;
+    for (size_t i = 0; i < strokeCount; ++i)
+    {
+        fileNames.push_back("StrokeLoadBenchmark" + std::to_string(i) + ".txt");
+
+        FILE* file = std::fopen(fileNames.back().c_str(), "w");
+        for (size_t j = 0; j < pointCount; ++j)
+        {
+            float a = 0.001f * j + i;
+            std::fprintf(file, "%.9g %.9g %.9g\n", 100.0f * std::cos(a), 100.0f * std::sin(a), 0.01f * j);
+        }
+        std::fclose(file);
+    }
+    return fileNames;
+}
+
+/**
+ * Former loadSplineFromFile parsing
+ */
+static std::vector<glm::vec3> readStream(const std::string& fileName)
+{
+    std::vector<glm::vec3> points;
+    std::ifstream stream(fileName);
+
+    std::string line;
+    while (getline(stream, line))
+    {
+        std::stringstream ss(line);
+
+        float x, y, z;
+        ss >> x >> y >> z;
+
+        points.push_back(glm::vec3(x, y, z));
+    }
+    return points;
+}
+
+static void benchmark(size_t strokeCount, size_t pointCount)
+{
+    std::vector<std::string> textFiles = writeTextFiles(strokeCount, pointCount);
+    std::printf("%zu strokes of %zu points\n", strokeCount, pointCount);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<glm::vec3>> reference;
+    for (const std::string& fileName : textFiles)
+        reference.push_back(readStream(fileName));
+    std::printf("  getline + stringstream:        %9.2f ms\n", elapsedMs(start));
+
+    size_t mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < strokeCount; ++i)
+    {
+        std::vector<glm::vec3> points;
+        StrokeFile::readText(textFiles[i], points);
+        mismatches += (points != reference[i]);
+    }
+    std::printf("  StrokeFile::readText:          %9.2f ms\n", elapsedMs(start));
+
+    start = std::chrono::steady_clock::now();
+    StrokeFile::convertText(textFiles, BINARY_FILE);
+    std::printf("  convertText (once):            %9.2f ms\n", elapsedMs(start));
+
+    // Strokes are used in place: the scan touches every point, so that the pages are mapped
+    start = std::chrono::steady_clock::now();
+    {
+        StrokeFile file;
+        file.open(BINARY_FILE);
+
+        glm::vec3 sum(0.0f);
+        for (size_t i = 0; i < file.getStrokeCount(); ++i)
+        {
+            StrokeFile::StrokeView stroke = file.getStroke(i);
+            for (size_t j = 0; j < stroke.count; ++j)
+                sum += stroke.points[j];
+        }
+        std::printf("  binary open + scan:            %9.2f ms (sum %g)\n", elapsedMs(start), sum.x + sum.y + sum.z);
+    }
+
+    start = std::chrono::steady_clock::now();
+    {
+        StrokeFile file;
+        file.open(BINARY_FILE);
+
+        std::vector<CurvePtr> curves;
+        for (size_t i = 0; i < file.getStrokeCount(); ++i)
+            curves.push_back(file.createCurve(i));
+        std::printf("  binary open + createCurve:     %9.2f ms\n", elapsedMs(start));
+
+        mismatches += (file.getStrokeCount() != strokeCount);
+        for (size_t i = 0; i < curves.size() && i < strokeCount; ++i)
+            mismatches += (curves[i]->getControlPoints() != reference[i]);
+    }
+    std::printf("  mismatches: %zu\n", mismatches);
+
+    for (const std::string& fileName : textFiles)
+        std::remove(fileName.c_str());
+    std::remove(BINARY_FILE);
+}
+
+int main()
+{
+    benchmark(200, 2000);
+    benchmark(10, 100000);
+    return 0;
+}